@@ -0,0 +1,43 @@
+/**
+ * @file coalesce.hpp
+ * @author Gabriel Gonzalez
+ * 
+ * @brief Coalesce duplicate notifications into the one that is on screen.
+ */
+
+#ifndef ARIA_COALESCE_HPP
+#define ARIA_COALESCE_HPP
+
+#include "aria.hpp"
+#include "commandline.hpp"
+
+ARIA_NAMESPACE
+
+/**
+ * @namespace coalesce
+ * 
+ * @brief Hand a notification whose title and body match one that is on
+ *        screen to that notification, which shows a repeat counter, instead
+ *        of displaying another notification bubble.
+ */
+namespace coalesce
+{
+    /**
+     * @brief Hash the title and body of a notification.
+     * 
+     * @param[in] cli The command line interface.
+     */
+    unsigned long key(commandline::interface& cli);
+
+    /**
+     * @brief Hand the notification to a notification on screen with the same
+     *        title and body.
+     * 
+     * @param[in] cli The command line interface.
+     */
+    bool forward(commandline::interface& cli);
+}
+
+ARIA_NAMESPACE_END
+
+#endif /* ARIA_COALESCE_HPP */
@@ -107,6 +107,28 @@ namespace commandline
          */
         void parse(char** argv);
 
+        /**
+         * @brief Parse a list of arguments that holds the options of several
+         *        groups, one after the other, split by a separator option.
+         * 
+         * @details The first group is parsed into this interface. Each group
+         *          after it gets its own interface, which takes the options
+         *          of the first group that it does not set itself, except for
+         *          the ones that are listed in own. An empty group is skipped.
+         * 
+         * @param[in] argv      List of command line arguments, typically from
+         *                      the main(argc, argv) function.
+         * @param[in] separator The option that starts another group, e.g.
+         *                      '--next'. It must be in the list of options.
+         * @param[in] own       Options that each group only has if it sets
+         *                      them itself.
+         * 
+         * @return The interfaces of the groups after the first one.
+         */
+        std::vector<interface> parse_groups(char** argv,
+                                            std::string separator,
+                                            std::vector<std::string> own);
+
         /**
          * @brief Print the command line options that have been entered, to
          *        ensure they were read correctly.
@@ -189,6 +211,8 @@ namespace commandline
          *         NULL if an error occurs.
          * 
          * @note If the long option '--help' is found, usage() will be called.
+         *       Any other option without an argument is stored with an empty
+         *       value, so that has() can be used to check for it.
          */
         char** parse_argument(const option_t* data, char** argp,
                               bool& listflag);
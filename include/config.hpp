@@ -26,6 +26,7 @@ ARIA_NAMESPACE
 
 namespace config
 {
+    GKeyFile* load(void);
     std::string read(const char* group, const char* key);
     std::string read(const char* key);
     std::string read_str(const char* group, const char* key);
@@ -0,0 +1,95 @@
+/**
+ * @file follow.hpp
+ * @author Gabriel Gonzalez
+ * 
+ * @brief Watch a file, and display the lines written to it that match a
+ *        pattern.
+ */
+
+#ifndef ARIA_FOLLOW_HPP
+#define ARIA_FOLLOW_HPP
+
+#include "aria.hpp"
+#include "commandline.hpp"
+#include <sys/types.h>
+#include <deque>
+#include <string>
+
+ARIA_NAMESPACE
+
+/**
+ * @namespace follow
+ * 
+ * @brief Watch the file given to --follow with inotify, like "tail -F", and
+ *        display a notification for the lines that match --match.
+ * 
+ * @details A single process watches the file, and only reads what was
+ *          appended to it, when inotify reports a change. The pattern is
+ *          compiled once, and run over a whole chunk of input at a time, so
+ *          that lines that do not match cost no more than the search itself.
+ *          Matches that arrive close together are batched into one
+ *          notification, which is displayed by a child process forked from
+ *          the watcher, so that neither the toolkit nor another program is
+ *          ever started for a line that does not match. Each child still
+ *          starts the toolkit, and goes through admission and placement, on
+ *          its own, like any other notification, which bounds the cost to one
+ *          startup per batch, i.e. at most one every kBatchTime.
+ */
+namespace follow
+{
+    /**
+     * @brief Time that the first match of a batch waits for more matches,
+     *        before they are displayed, in milliseconds.
+     */
+    const int kBatchTime = 500;
+
+    /**
+     * @brief Maximum number of matching lines in the body of a notification.
+     *        The most recent ones are kept.
+     */
+    const size_t kBatchLines = 5;
+
+    /**
+     * @struct source
+     *
+     * @brief The file that is followed.
+     */
+    struct source
+    {
+        std::string path;    /**< Path to the file. */
+        std::string name;    /**< Name of the file, without its directory. */
+        int         inotify; /**< Inotify instance. */
+        int         filewd;  /**< Watch on the file, or -1. */
+        int         dirwd;   /**< Watch on its directory, for a new file after
+                                  a rotation. */
+        int         fd;      /**< File descriptor, or -1 while there is no
+                                  file. */
+        ino_t       inode;   /**< Inode of the file that is open. */
+        std::string partial; /**< Start of a line that is not complete yet. */
+    };
+
+    /**
+     * @struct batch
+     *
+     * @brief Matching lines that are waiting to be displayed.
+     */
+    struct batch
+    {
+        std::deque<std::string> lines;    /**< Most recent matching lines. */
+        unsigned long           count;    /**< Number of matching lines. */
+        double                  deadline; /**< Time at which they are
+                                               displayed, in milliseconds. */
+    };
+
+    /**
+     * @brief Watch the file, and fork a child to display each batch of
+     *        matching lines.
+     *
+     * @param[in,out] cli The command line interface.
+     */
+    int run(commandline::interface& cli);
+}
+
+ARIA_NAMESPACE_END
+
+#endif /* ARIA_FOLLOW_HPP */
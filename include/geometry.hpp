@@ -0,0 +1,273 @@
+/**
+ * @file geometry.hpp
+ * @author Gabriel Gonzalez
+ * 
+ * @brief Monitor geometry of the X screen.
+ */
+
+#ifndef ARIA_GEOMETRY_HPP
+#define ARIA_GEOMETRY_HPP
+
+#include "aria.hpp"
+#include "sharedmem.hpp"
+#include <X11/Xlib.h>
+#include <X11/Xatom.h>
+#include <string>
+#include <vector>
+
+ARIA_NAMESPACE
+
+/**
+ * @namespace geometry
+ * 
+ * @brief Query and cache the geometry of each monitor on the X screen.
+ */
+namespace geometry
+{
+    /**
+     * @struct area
+     * 
+     * @brief Position and size of an area, in root window coordinates.
+     */
+    struct area
+    {
+        int x;      /**< X-coordinate of the area. */
+        int y;      /**< Y-coordinate of the area. */
+        int width;  /**< Width of the area. */
+        int height; /**< Height of the area. */
+    };
+
+    /**
+     * @struct monitor
+     * 
+     * @brief Position and size of a monitor, in root window coordinates.
+     */
+    struct monitor
+    {
+        int  x;       /**< X-coordinate of the monitor. */
+        int  y;       /**< Y-coordinate of the monitor. */
+        int  width;   /**< Width of the monitor. */
+        int  height;  /**< Height of the monitor. */
+        bool primary; /**< Whether this is the primary monitor. */
+        struct area workarea; /**< Area of the monitor not taken up by panels
+                                   and docks. */
+    };
+
+    /**
+     * @brief Type name for the list of monitors on a screen.
+     */
+    typedef std::vector<struct monitor> monitorlist_t;
+
+    /**
+     * @brief Retrieve the geometry of each monitor.
+     * 
+     * @param[in]  display  An open connection to the X server.
+     * @param[out] monitors The list of monitors.
+     */
+    int get(Display* display, monitorlist_t& monitors);
+
+    /**
+     * @brief Select a monitor.
+     * 
+     * @param[in]  display An open connection to the X server.
+     * @param[in]  which   The monitor to select: its index, "primary",
+     *                     "pointer", or "focused".
+     * @param[out] index   Index of the selected monitor.
+     * @param[out] monitor The selected monitor.
+     */
+    int select(Display* display, const std::string& which, int& index,
+               struct monitor& monitor);
+
+    /**
+     * @brief Find the monitor that contains a point.
+     * 
+     * @param[in] monitors The list of monitors.
+     * @param[in] x        X-coordinate of the point.
+     * @param[in] y        Y-coordinate of the point.
+     */
+    int find(const monitorlist_t& monitors, int x, int y);
+
+    /**
+     * @brief Find the primary monitor.
+     * 
+     * @param[in] monitors The list of monitors.
+     */
+    int find_primary(const monitorlist_t& monitors);
+
+    /**
+     * @brief Guess the monitor that a notification bubble will be displayed
+     *        on, before connecting to the X server.
+     * 
+     * @param[in] spec     The monitor option: an index, "primary", "pointer",
+     *                     or "focused".
+     * @param[in] monitors The list of monitors.
+     */
+    int guess(const std::string& spec, const monitorlist_t& monitors);
+
+    /**
+     * @brief Determine the position of the mouse pointer.
+     * 
+     * @param[in]  display An open connection to the X server.
+     * @param[out] x       X-coordinate of the pointer.
+     * @param[out] y       Y-coordinate of the pointer.
+     */
+    int get_pointer(Display* display, int& x, int& y);
+
+    /**
+     * @brief Determine the center of the focused window.
+     * 
+     * @param[in]  display An open connection to the X server.
+     * @param[out] x       X-coordinate of the center of the window.
+     * @param[out] y       Y-coordinate of the center of the window.
+     */
+    int get_focused(Display* display, int& x, int& y);
+
+    /**
+     * @brief Retrieve the work area of the current desktop.
+     * 
+     * @param[in]  display  An open connection to the X server.
+     * @param[out] workarea The work area.
+     */
+    int get_workarea(Display* display, struct area& workarea);
+
+    /**
+     * @brief Load the geometry that was published in shared memory.
+     * 
+     * @param[in] display An open connection to the X server.
+     */
+    int load(Display* display);
+
+    /**
+     * @brief Read the geometry that was published in shared memory, without
+     *        checking it against the X server.
+     * 
+     * @param[out] monitors The list of monitors.
+     */
+    int peek(monitorlist_t& monitors);
+
+    /**
+     * @brief Convert the geometry in shared memory to a list of monitors.
+     * 
+     * @param[in]  g        The geometry in shared memory.
+     * @param[out] monitors The list of monitors.
+     */
+    void unpack(const struct SharedMemGeometry& g, monitorlist_t& monitors);
+
+    /**
+     * @brief Query the X server for the geometry of each monitor, and publish
+     *        it in shared memory.
+     * 
+     * @param[in] display An open connection to the X server.
+     */
+    int query(Display* display);
+
+    /**
+     * @brief Query the X server for the RandR configuration timestamp.
+     * 
+     * @param[in] display An open connection to the X server.
+     */
+    long config_timestamp(Display* display);
+
+    /**
+     * @brief Query the X server for the work area of the current desktop.
+     * 
+     * @param[in]  display  An open connection to the X server.
+     * @param[out] workarea The work area.
+     */
+    int query_workarea(Display* display, struct area& workarea);
+
+    /**
+     * @brief Determine the usable area of each monitor from the struts that
+     *        panels and docks reserve.
+     * 
+     * @param[in]     display  An open connection to the X server.
+     * @param[in,out] monitors The list of monitors.
+     * @param[in]     workarea The work area of the current desktop.
+     */
+    int query_struts(Display* display, monitorlist_t& monitors,
+                     const struct area& workarea);
+
+    /**
+     * @brief Remove the area reserved by a strut from the usable area of a
+     *        monitor.
+     * 
+     * @param[in,out] monitor The monitor.
+     * @param[in]     strut   The strut, in the _NET_WM_STRUT_PARTIAL format.
+     * @param[in]     rootw   Width of the root window.
+     * @param[in]     rooth   Height of the root window.
+     */
+    void apply_strut(struct monitor& monitor, const std::vector<long>& strut,
+                     int rootw, int rooth);
+
+    /**
+     * @brief Determine the stack that a notification bubble belongs to, from
+     *        its gravity.
+     * 
+     * @param[in] name The gravity: "top-left", "top-right", "bottom-left", or
+     *                 "bottom-right".
+     */
+    long gravity(const std::string& name);
+
+    /**
+     * @brief Place a notification bubble in the work area of a monitor,
+     *        relative to the corner given by its gravity.
+     * 
+     * @param[in]     workarea The work area of the monitor.
+     * @param[in]     gravity  The gravity of the notification bubble.
+     * @param[in,out] x        X-offset from the corner, and then the
+     *                         X-position on the screen.
+     * @param[in,out] y        Y-offset from the corner, and then the
+     *                         Y-position on the screen.
+     * @param[in]     width    Width of the notification bubble.
+     * @param[in]     height   Height of the notification bubble.
+     */
+    void place(const struct area& workarea, long gravity, int& x, int& y,
+               int width, int height);
+
+    /**
+     * @brief Check if an event announces a change to the work area.
+     * 
+     * @param[in] display An open connection to the X server.
+     * @param[in] event   The event.
+     */
+    bool is_workarea_event(Display* display, XEvent* event);
+
+    /**
+     * @brief Ignore an X error, e.g. from a client window that was destroyed
+     *        while its struts were being read.
+     * 
+     * @param[in] display An open connection to the X server.
+     * @param[in] error   The error.
+     */
+    int ignore_error(Display* display, XErrorEvent* error);
+
+    /**
+     * @brief Read a property of a window that is a list of 32-bit values.
+     * 
+     * @param[in]  display An open connection to the X server.
+     * @param[in]  window  The window to read the property of.
+     * @param[in]  name    Name of the property.
+     * @param[out] values  Values of the property.
+     * @param[in]  type    Type of the property.
+     */
+    int get_property(Display* display, Window window, const char* name,
+                     std::vector<long>& values, Atom type=XA_CARDINAL);
+
+    /**
+     * @brief Query the X server for the current geometry, after it reported
+     *        that the monitor layout changed, and publish it.
+     * 
+     * @param[in] display An open connection to the X server.
+     */
+    int refresh(Display* display);
+
+    /**
+     * @brief Discard the cached monitor geometry, so that it is retrieved again
+     *        the next time it is needed.
+     */
+    void invalidate(void);
+}
+
+ARIA_NAMESPACE_END
+
+#endif /* ARIA_GEOMETRY_HPP */
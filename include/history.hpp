@@ -0,0 +1,114 @@
+/**
+ * @file history.hpp
+ * @author Gabriel Gonzalez
+ * 
+ * @brief History of the notifications that were shown, kept in a ring buffer
+ *        that is shared between processes.
+ */
+
+#ifndef ARIA_HISTORY_HPP
+#define ARIA_HISTORY_HPP
+
+#include "aria.hpp"
+#include "commandline.hpp"
+#include <cstddef>
+#include <string>
+
+ARIA_NAMESPACE
+
+/**
+ * @namespace history
+ * 
+ * @brief Append every notification that is shown to a fixed size ring buffer
+ *        in a file under $XDG_RUNTIME_DIR, and list or search it with
+ *        --history.
+ * 
+ * @details Each process maps the file, and appends an entry by taking the next
+ *          sequence number from the header with an atomic increment, so that
+ *          appending never takes a lock. Once the ring is full, the oldest
+ *          entries are overwritten.
+ */
+namespace history
+{
+    /**
+     * @brief Number of entries in the ring buffer.
+     */
+    const size_t kLength = 16384;
+
+    /**
+     * @brief Number of bytes of text in an entry. Text past it is cut off.
+     */
+    const size_t kText = 984;
+
+    /**
+     * @struct entry
+     *
+     * @brief A notification that was shown.
+     *
+     * @details The title, body, and tag are stored back to back, each followed
+     *          by a null character, so that a search can not match across two
+     *          of them.
+     */
+    struct entry
+    {
+        unsigned long sequence; /**< 2n+2 once entry n is written, and odd
+                                     while it is being written. */
+        long          time;     /**< Time it was shown, in seconds since the
+                                     epoch. */
+        long          urgency;  /**< Urgency, see SharedMemUrgency. */
+        unsigned int  titlelen; /**< Length of the title. */
+        unsigned int  bodylen;  /**< Length of the body. */
+        unsigned int  taglen;   /**< Length of the tag. */
+        unsigned int  unused;   /**< Padding. */
+        char          text[kText]; /**< Title, body, and tag. */
+    };
+
+    /**
+     * @struct header
+     *
+     * @brief Header at the start of the file.
+     */
+    struct header
+    {
+        unsigned long magic; /**< Identifies the layout of the file. */
+        unsigned long head;  /**< Sequence number of the next entry. */
+    };
+
+    /**
+     * @brief Path to the file that holds the history.
+     */
+    std::string path(void);
+
+    /**
+     * @brief Open and map the history file.
+     */
+    int open(void);
+
+    /**
+     * @brief Append a notification to the history.
+     *
+     * @param[in] cli The command line interface.
+     */
+    int append(commandline::interface& cli);
+
+    /**
+     * @brief Print the notifications in the history that match --grep and
+     *        --since.
+     *
+     * @param[in] cli The command line interface.
+     */
+    int print(commandline::interface& cli);
+
+    /**
+     * @brief Check whether text contains a pattern.
+     *
+     * @param[in] text    The text.
+     * @param[in] length  Length of the text.
+     * @param[in] pattern The pattern.
+     */
+    bool contains(const char* text, size_t length, const std::string& pattern);
+}
+
+ARIA_NAMESPACE_END
+
+#endif /* ARIA_HISTORY_HPP */
@@ -15,6 +15,8 @@
 
 #include "aria.hpp"
 #include "commandline.hpp"
+#include "geometry.hpp"
+#include "progress.hpp"
 #include <gtkmm.h>
 #include <string>
 
@@ -34,6 +36,11 @@ public:
      */
     notification();
 
+    /**
+     * @brief Stop handling signals and events for the notification bubble.
+     */
+    ~notification();
+
     /**
      * @brief Build the notification bubble and set all attributes.
      * 
@@ -61,6 +68,15 @@ public:
                                   std::string& font, std::string& titlesize,
                                   std::string& bodysize);
 
+    /**
+     * @brief Set the maximum number of lines and line width of the title and
+     *        body text.
+     * 
+     * @param[in] lines Maximum number of lines, before the text is ellipsized.
+     * @param[in] width Maximum width of a line, in characters.
+     */
+    int set_notify_text_limit(std::string& lines, std::string& width);
+
     /**
      * @brief Set the notification icon.
      * 
@@ -94,6 +110,14 @@ public:
     int set_notify_position(std::string& xpos, std::string& ypos,
                             std::string& gravity);
 
+    /**
+     * @brief Set the monitor to display the notification bubble on.
+     * 
+     * @param[in] monitor The index of the monitor, "primary", "pointer", or
+     *                    "focused".
+     */
+    int set_notify_monitor(std::string& monitor);
+
     /**
      * @brief Set the notification background, foreground, and opacity.
      * 
@@ -125,6 +149,24 @@ public:
                           std::string& mbottom, std::string& mleft,
                           std::string& mright);
 
+    /**
+     * @brief Set the duration of the fade and slide animations.
+     * 
+     * @param[in] fadein  Duration of the fade in, in milliseconds.
+     * @param[in] fadeout Duration of the fade out, in milliseconds.
+     * @param[in] slide   Duration of a move to a new position, in
+     *                    milliseconds.
+     */
+    int set_notify_animation(std::string& fadein, std::string& fadeout,
+                             std::string& slide);
+
+    /**
+     * @brief Set the source that the progress bar is read from.
+     * 
+     * @param[in] source "-" for stdin, or the path to a file or FIFO.
+     */
+    int set_notify_progress(std::string& source);
+
 protected:
     /**
      * @brief Resize the notification bubble to the desired size, if specified,
@@ -132,11 +174,66 @@ protected:
      */
     void resize(void);
 
+    /**
+     * @brief Measure the preferred size of the notification bubble.
+     * 
+     * @param[out] width  The preferred width.
+     * @param[out] height The preferred height.
+     */
+    void measure(int& width, int& height);
+
+    /**
+     * @brief Verify a size that was taken from the size cache against the
+     *        actual layout.
+     * 
+     * @param[in] autowidth  Whether the width was taken from the size cache.
+     * @param[in] autoheight Whether the height was taken from the size cache.
+     */
+    void verify_size(bool autowidth, bool autoheight);
+
     /**
      * @brief Move the notification bubble to the desired position.
      */
     void reposition(void);
 
+    /**
+     * @brief Install the stylesheet that was generated while building the
+     *        notification bubble.
+     */
+    void apply_style(void);
+
+    /**
+     * @brief Remove the notification bubble from its stack and fade it out.
+     */
+    void dismiss(void);
+
+    /**
+     * @brief Move the notification bubble to a new position, sliding it there
+     *        if it is already on screen.
+     * 
+     * @param[in] x X-position on the screen.
+     * @param[in] y Y-position on the screen.
+     */
+    void slide_to(int x, int y);
+
+    /**
+     * @brief Fade the notification bubble to the given opacity.
+     * 
+     * @param[in] opacity  The final opacity of the window.
+     * @param[in] duration Duration of the fade, in milliseconds.
+     */
+    void fade_to(double opacity, int duration);
+
+    /**
+     * @brief Make sure that the animations are advanced on every frame.
+     */
+    void animate(void);
+
+    /**
+     * @brief Print the frame statistics of the animations that just finished.
+     */
+    void report_frames(void);
+
     /**
      * @brief Set the title of the notification bubble.
      * 
@@ -161,8 +258,10 @@ protected:
      * @param[in] text Text for the label.
      * @param[in] font Font for the text.
      * @param[in] size Font size for the text.
+     * @param[in] name Style class of the label, "title" or "body".
      */
-    int set_text(std::string text, std::string font, std::string size);
+    int set_text(std::string text, std::string font, std::string size,
+                 const std::string name);
 
     /**
      * @brief Set the title size.
@@ -234,27 +333,18 @@ protected:
     int set_from_config(const std::string key, std::string& value);
 
     /**
-     * @brief Parse the color string and convert it to a '#123456' string if the
-     *        input is a hex string.
-     * 
-     * @param[in] color The color hex string.
-     */
-    std::string fix_color(std::string& color);
-
-    /**
-     * @brief Determine the screen resolution for monitor 0 from 
+     * @brief Determine the monitor to display the notification bubble on.
      * 
-     * @param[out] width  The width of the monitor.
-     * @param[out] height The height of the monitor.
+     * @param[out] index   Index of the monitor.
+     * @param[out] monitor Position and size of the monitor.
      */
-    int get_screen_resolution(int& width, int& height);
+    int get_monitor(int& index, struct geometry::monitor& monitor);
 
     /**
-     * @brief Check if the color string is in a hex format.
-     * 
-     * @param[in] color The color string to check.
+     * @brief Determine the stack that the notification bubble belongs to, from
+     *        its gravity.
      */
-    bool is_hex_color(std::string& color);
+    long get_gravity(void);
 
     /**
      * @brief Draw the notification bubble.
@@ -271,14 +361,147 @@ protected:
      */
     void on_screen_changed(const Glib::RefPtr<Gdk::Screen>& previous_screen);
 
+    /**
+     * @brief Query the monitor geometry again, when the monitor layout
+     *        changes.
+     */
+    void on_monitors_changed(void);
+
+    /**
+     * @brief Replace the title, body, or icon, with new contents that were
+     *        handed to the notification bubble by tag.
+     * 
+     * @param[in] p The new contents.
+     */
+    void replace(const struct SharedMemPayload& p);
+
+    /**
+     * @brief Start the timeout that dismisses the notification bubble over.
+     */
+    void restart_timeout(void);
+
+    /**
+     * @brief Set the text of a label.
+     * 
+     * @param[in] label The label.
+     * @param[in] text  The text.
+     */
+    void set_label_text(Gtk::Label* label, std::string text);
+
+    /**
+     * @brief Advance the animations to the time of the current frame.
+     * 
+     * @param[in] clock The frame clock of the window.
+     */
+    bool on_tick(const Glib::RefPtr<Gdk::FrameClock>& clock);
+
+    /**
+     * @brief Watch the source of the progress bar for updates.
+     */
+    void watch_progress(void);
+
+    /**
+     * @brief Read the updates of the progress bar that are waiting.
+     * 
+     * @param[in] condition The condition of the source.
+     */
+    bool on_progress(Glib::IOCondition condition);
+
+    /**
+     * @brief Display the latest update of the progress bar.
+     * 
+     * @param[in] clock The frame clock of the window.
+     */
+    bool on_progress_tick(const Glib::RefPtr<Gdk::FrameClock>& clock);
+
+    /**
+     * @brief Draw the progress bar.
+     * 
+     * @param[in] cr Cairo drawing context.
+     */
+    bool on_bar_draw(const ::Cairo::RefPtr< ::Cairo::Context>& cr);
+
+    /**
+     * @brief Move to the position in shared memory, after another notification
+     *        bubble in the same stack was removed.
+     * 
+     * @param[in] data The notification bubble.
+     */
+    static gboolean on_reflow(gpointer data);
+
+    /**
+     * @brief Show the new repeat count or contents, and restart the timeout,
+     *        after a duplicate or a replacement of the notification was sent.
+     * 
+     * @param[in] data The notification bubble.
+     */
+    static gboolean on_repeat(gpointer data);
+
+    /**
+     * @brief Dismiss the notification bubble, after the process was told to
+     *        quit.
+     * 
+     * @param[in] data The notification bubble.
+     */
+    static gboolean on_terminate(gpointer data);
+
+    /**
+     * @brief Query the monitor geometry again, when the work area changes
+     *        because a panel or dock was added, removed, or resized.
+     * 
+     * @param[in] xevent The X event received on the root window.
+     * @param[in] event  The GDK event, unused.
+     * @param[in] data   The notification bubble.
+     */
+    static GdkFilterReturn on_root_event(GdkXEvent* xevent, GdkEvent* event,
+                                         gpointer data);
+
 private:
     /**
-     * @brief Cleanup any memory mapped data and gracefully shutdown program.
+     * @struct tween
      * 
-     * @param[in] sig The signal that was captured, to cause the cleanup function to
-     *                run.
+     * @brief A value that is animated over a period of time.
      */
-    static void cleanup(int sig);
+    struct tween
+    {
+        gint64 start;    /**< Frame time at which the animation started, in
+                              microseconds, or -1 if it starts on the next
+                              frame. */
+        int    duration; /**< Duration of the animation, in milliseconds. */
+        double from;     /**< Value at the start of the animation. */
+        double to;       /**< Value at the end of the animation. */
+        bool   active;   /**< Whether the animation is running. */
+    };
+
+    /**
+     * @brief Determine the value of an animation at the given frame time.
+     * 
+     * @param[in,out] t   The animation.
+     * @param[in]     now The frame time, in microseconds.
+     */
+    static double advance(struct tween& t, gint64 now);
+
+    /**
+     * @brief Turn SIGQUIT into SIGTERM, which is handled from the main loop.
+     * 
+     * @param[in] sig The signal that was captured.
+     */
+    static void on_quit(int sig);
+
+    /**
+     * @brief Select the entry of the notification bubble in shared memory,
+     *        before operating on it.
+     */
+    void select_entry(void);
+
+    /**
+     * @brief Add a rule to the stylesheet of the notification bubble.
+     * 
+     * @param[in] name         Style class of the widget, or "aria" for the
+     *                         window itself.
+     * @param[in] declarations Declarations of the rule.
+     */
+    void add_rule(const std::string& name, const std::string& declarations);
 
     /**
      * @brief Main container for the icon and text containers.
@@ -298,6 +521,11 @@ private:
      */
     Gtk::Box text_;
 
+    /**
+     * @brief Progress bar, under the title and body text.
+     */
+    Gtk::DrawingArea bar_;
+
     /**
      * @brief Background color of the notification bubble.
      * 
@@ -307,6 +535,12 @@ private:
      */
     Gdk::RGBA background_;
 
+    /**
+     * @brief Text color of the notification bubble, which the progress bar is
+     *        drawn in.
+     */
+    Gdk::RGBA foreground_;
+
     /**
      * @brief Width of the notification bubble.
      */
@@ -334,10 +568,279 @@ private:
      */
     std::string gravity_;
 
+    /**
+     * @brief Monitor to display the notification bubble on.
+     */
+    std::string monitor_;
+
     /**
      * @brief Curvature of the corners on the notification bubble.
      */
     int curve_;
+
+    /**
+     * @brief Display the title and body as plain text, even if they contain
+     *        markup.
+     */
+    bool plain_;
+
+    /**
+     * @brief Maximum number of lines of the title or body text. A value of 0
+     *        means there is no limit.
+     */
+    int maxlines_;
+
+    /**
+     * @brief Maximum width of a line of text, in characters. A value of 0
+     *        means there is no limit.
+     */
+    int maxwidth_;
+
+    /**
+     * @brief Hash of all the attributes that determine the size of the
+     *        notification bubble, used as the key in the size cache.
+     */
+    unsigned long sizekey_;
+
+    /**
+     * @brief Hash of the title and body, used to find duplicates of the
+     *        notification bubble in shared memory.
+     */
+    unsigned long contentkey_;
+
+    /**
+     * @brief Number of times the notification bubble was sent, shown as a
+     *        repeat counter when more than one.
+     */
+    long count_;
+
+    /**
+     * @brief Amount of time to display the notification bubble, in seconds.
+     */
+    int time_;
+
+    /**
+     * @brief Timeout that dismisses the notification bubble.
+     */
+    sigc::connection timeout_;
+
+    /**
+     * @brief Hash of the tag of the notification bubble, or 0.
+     */
+    unsigned long tagkey_;
+
+    /**
+     * @brief Urgency of the notification bubble, see SharedMemUrgency.
+     */
+    long urgency_;
+
+    /**
+     * @brief Sequence counter of the contents that were last read from the
+     *        mailbox of the tag.
+     */
+    unsigned long seen_;
+
+    /**
+     * @brief Label of the title, or NULL.
+     */
+    Gtk::Label* title_;
+
+    /**
+     * @brief Label of the body, or NULL.
+     */
+    Gtk::Label* body_;
+
+    /**
+     * @brief Image of the icon, or NULL.
+     */
+    Gtk::Image* image_;
+
+    /**
+     * @brief Font of the title and body, kept to add a label that the
+     *        notification bubble was built without.
+     */
+    std::string font_;
+
+    /**
+     * @brief Font size of the title.
+     */
+    std::string titlesize_;
+
+    /**
+     * @brief Font size of the body.
+     */
+    std::string bodysize_;
+
+    /**
+     * @brief Whether the width was not given, and is measured.
+     */
+    bool autowidth_;
+
+    /**
+     * @brief Whether the height was not given, and is measured.
+     */
+    bool autoheight_;
+
+    /**
+     * @brief Source of the progress bar, and the latest update read from it.
+     */
+    struct progress::stream progress_;
+
+    /**
+     * @brief Fraction of the progress bar that is displayed.
+     */
+    double fraction_;
+
+    /**
+     * @brief ID of the tick callback that displays the latest update of the
+     *        progress bar, or 0 if none is waiting.
+     * 
+     * @details The source is not watched while an update is waiting, so that
+     *          it is read, and the bar drawn, at most once per frame.
+     */
+    guint progresstick_;
+
+    /**
+     * @brief Stylesheet for the fonts, colors, and margins of the notification
+     *        bubble.
+     * 
+     * @details Rules are appended as each attribute is resolved, and the
+     *          stylesheet is loaded into a CSS provider in show().
+     */
+    std::string stylesheet_;
+
+    /**
+     * @brief CSS provider that the stylesheet is loaded into.
+     */
+    Glib::RefPtr<Gtk::CssProvider> provider_;
+
+    /**
+     * @brief Index of the monitor, and stack, that the notification bubble is
+     *        on.
+     */
+    int index_;
+
+    /**
+     * @brief ID of the entry of the notification bubble in shared memory.
+     * 
+     * @details This is the PID, unless the process displays several
+     *          notification bubbles, see SHAREDMEM_IDSHIFT.
+     */
+    long id_;
+
+    /**
+     * @brief ID of the source that handles SIGUSR1.
+     */
+    guint reflowsource_;
+
+    /**
+     * @brief ID of the source that handles SIGUSR2.
+     */
+    guint repeatsource_;
+
+    /**
+     * @brief ID of the source that handles SIGINT.
+     */
+    guint interruptsource_;
+
+    /**
+     * @brief ID of the source that handles SIGTERM.
+     */
+    guint terminatesource_;
+
+    /**
+     * @brief Current x-position of the notification bubble on screen.
+     */
+    int xcur_;
+
+    /**
+     * @brief Current y-position of the notification bubble on screen.
+     */
+    int ycur_;
+
+    /**
+     * @brief Duration of the fade in, in milliseconds.
+     */
+    int fadeintime_;
+
+    /**
+     * @brief Duration of the fade out, in milliseconds.
+     */
+    int fadeouttime_;
+
+    /**
+     * @brief Duration of a move to a new position, in milliseconds.
+     */
+    int slidetime_;
+
+    /**
+     * @brief Opacity animation of the window.
+     */
+    struct tween fade_;
+
+    /**
+     * @brief X-position animation of the window.
+     */
+    struct tween slidex_;
+
+    /**
+     * @brief Y-position animation of the window.
+     */
+    struct tween slidey_;
+
+    /**
+     * @brief ID of the tick callback that advances the animations, or 0 if no
+     *        animation is running.
+     * 
+     * @details The callback is removed as soon as every animation finishes,
+     *          so that nothing runs while the notification bubble is idle.
+     */
+    guint tick_;
+
+    /**
+     * @brief Whether the notification bubble was removed from its stack, and
+     *        is being faded out.
+     */
+    bool dismissed_;
+
+    /**
+     * @brief Whether the notification bubble has an entry in its stack. It is
+     *        shown outside of the stack if the stack was full.
+     */
+    bool placed_;
+
+    /**
+     * @brief Whether to print the number of frames, dropped frames, and draw
+     *        time of each animation.
+     */
+    bool framestats_;
+
+    /**
+     * @brief Frame time of the previous frame of the animation, in
+     *        microseconds.
+     */
+    gint64 lastframe_;
+
+    /**
+     * @brief Number of frames drawn during the animation.
+     */
+    int frames_;
+
+    /**
+     * @brief Number of frames dropped during the animation.
+     */
+    int dropped_;
+
+    /**
+     * @brief Total time spent drawing during the animation, in milliseconds.
+     */
+    double drawtime_;
+
+    /**
+     * @brief Longest time spent drawing a single frame during the animation,
+     *        in milliseconds.
+     */
+    double drawmax_;
 };
 
 ARIA_NAMESPACE_END
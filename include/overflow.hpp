@@ -0,0 +1,54 @@
+/**
+ * @file overflow.hpp
+ * @author Gabriel Gonzalez
+ * 
+ * @brief Decide what to do with a notification when its stack is full.
+ */
+
+#ifndef ARIA_OVERFLOW_HPP
+#define ARIA_OVERFLOW_HPP
+
+#include "aria.hpp"
+#include "commandline.hpp"
+
+ARIA_NAMESPACE
+
+/**
+ * @namespace overflow
+ * 
+ * @brief Apply the policy that is chosen with --on-full, before the toolkit is
+ *        started.
+ * 
+ * @details The policy is one of:
+ * 
+ *            - drop: discard the notification.
+ *            - wait: sleep until the stack has room, for at most --max-wait
+ *                    seconds, and discard the notification after that.
+ *            - replace-oldest: make room by closing the oldest of the least
+ *                              urgent notifications in the stack, as long
+ *                              as it is not more urgent than the new one.
+ * 
+ *          A critical notification always makes room by closing the oldest of
+ *          the least urgent notifications, if any is not critical, before the
+ *          policy is applied.
+ */
+namespace overflow
+{
+    /**
+     * @brief Determine the urgency of a notification.
+     * 
+     * @param[in] cli The command line interface.
+     */
+    long urgency(commandline::interface& cli);
+
+    /**
+     * @brief Make sure that the stack of the notification has room for it.
+     * 
+     * @param[in] cli The command line interface.
+     */
+    int admit(commandline::interface& cli);
+}
+
+ARIA_NAMESPACE_END
+
+#endif /* ARIA_OVERFLOW_HPP */
@@ -0,0 +1,73 @@
+/**
+ * @file progress.hpp
+ * @author Gabriel Gonzalez
+ * 
+ * @brief Read the updates of a progress bar from a pipe or a file.
+ */
+
+#ifndef ARIA_PROGRESS_HPP
+#define ARIA_PROGRESS_HPP
+
+#include "aria.hpp"
+#include <string>
+
+ARIA_NAMESPACE
+
+/**
+ * @namespace progress
+ * 
+ * @brief Read lines of the form "PERCENT[%] [TEXT]", e.g. "42% Linking", from
+ *        the source given to --progress, keeping only the latest one.
+ * 
+ * @details A producer may write far more updates than can be displayed, so
+ *          whatever is waiting is read in large chunks, and only the last
+ *          complete line of each is parsed. The notification bubble then
+ *          displays the latest update at most once per frame, no matter how
+ *          fast the updates are written.
+ */
+namespace progress
+{
+    /**
+     * @struct stream
+     *
+     * @brief The source of the updates, and the latest update read from it.
+     */
+    struct stream
+    {
+        int         fd;       /**< File descriptor, or -1 when not in progress
+                                   mode. */
+        std::string partial;  /**< Start of a line that is not complete yet. */
+        double      fraction; /**< Latest fraction of the bar, from 0 to 1. */
+        std::string text;     /**< Latest text, which may be empty. */
+        bool        newtext;  /**< Whether the text changed since it was last
+                                   displayed. */
+        bool        eof;      /**< Whether the end of the source was reached. */
+    };
+
+    /**
+     * @brief Open the source of the updates.
+     *
+     * @param[in]  source "-" for stdin, or the path to a file or FIFO.
+     * @param[out] s      The stream.
+     */
+    int open(const std::string& source, struct stream& s);
+
+    /**
+     * @brief Read everything that is waiting on the source, without blocking,
+     *        and keep the latest update.
+     *
+     * @param[in,out] s The stream.
+     */
+    bool read(struct stream& s);
+
+    /**
+     * @brief Close the source of the updates.
+     *
+     * @param[in,out] s The stream.
+     */
+    void close(struct stream& s);
+}
+
+ARIA_NAMESPACE_END
+
+#endif /* ARIA_PROGRESS_HPP */
@@ -0,0 +1,48 @@
+/**
+ * @file ratelimit.hpp
+ * @author Gabriel Gonzalez
+ * 
+ * @brief Limit the rate of notifications across every running process.
+ */
+
+#ifndef ARIA_RATELIMIT_HPP
+#define ARIA_RATELIMIT_HPP
+
+#include "aria.hpp"
+#include "commandline.hpp"
+
+ARIA_NAMESPACE
+
+/**
+ * @namespace ratelimit
+ * 
+ * @brief Token buckets, kept in the header of shared memory, that a
+ *        notification takes a token from before it starts the toolkit.
+ * 
+ * @details There is one bucket shared by all notifications, and one for each
+ *          title that is not empty. Their rates, in notifications per second,
+ *          and sizes are set in the config file. A rate of 0, the default,
+ *          disables the bucket.
+ */
+namespace ratelimit
+{
+    /**
+     * @brief Check whether a notification may be displayed.
+     * 
+     * @param[in] cli The command line interface.
+     */
+    bool allow(commandline::interface& cli);
+
+    /**
+     * @brief Take a token from a bucket.
+     * 
+     * @param[in] key       Key of the bucket, or 0 for the shared one.
+     * @param[in] ratekey   Config key of the rate of the bucket.
+     * @param[in] burstkey  Config key of the size of the bucket.
+     */
+    bool take(unsigned long key, const char* ratekey, const char* burstkey);
+}
+
+ARIA_NAMESPACE_END
+
+#endif /* ARIA_RATELIMIT_HPP */
@@ -0,0 +1,199 @@
+/**
+ * @file render.hpp
+ * @author Gabriel Gonzalez
+ * 
+ * @brief Lay out and draw a notification bubble with Cairo and Pango, without
+ *        a connection to a display.
+ */
+
+#ifndef ARIA_RENDER_HPP
+#define ARIA_RENDER_HPP
+
+#include "aria.hpp"
+#include "commandline.hpp"
+#include <cairo.h>
+#include <gdk/gdk.h>
+#include <pango/pangocairo.h>
+#include <string>
+
+ARIA_NAMESPACE
+
+/**
+ * @namespace render
+ * 
+ * @brief Lay out and draw a notification bubble onto any Cairo surface.
+ * 
+ * @details The layout follows that of the notification bubble window: the icon
+ *          and the title and body text are placed side by side, inside the
+ *          margins, and the result is centered in the bubble.
+ */
+namespace render
+{
+    /**
+     * @brief Minimum width of the progress bar, in pixels.
+     */
+    const int kBarWidth = 200;
+
+    /**
+     * @brief Height of the progress bar, in pixels.
+     */
+    const int kBarHeight = 6;
+
+    /**
+     * @brief Spacing between the text and the progress bar, in pixels.
+     */
+    const int kBarSpacing = 6;
+
+    /**
+     * @struct settings
+     * 
+     * @brief Every attribute of a notification bubble, resolved from the
+     *        command line and the config file.
+     */
+    struct settings
+    {
+        std::string title;     /**< Title text. */
+        std::string body;      /**< Body text. */
+        std::string font;      /**< Font family of the title and body. */
+        int         titlesize; /**< Font size of the title, in points. */
+        int         bodysize;  /**< Font size of the body, in points. */
+        int         maxlines;  /**< Maximum number of lines, or 0. */
+        int         maxwidth;  /**< Maximum width of a line, in characters, or
+                                    0. */
+        bool        plain;     /**< Whether to ignore markup in the text. */
+        std::string icon;      /**< Path to the icon, or empty. */
+        int         spacing;   /**< Spacing between the icon and text. */
+        int         width;     /**< Width of the bubble, or 0 to fit. */
+        int         height;    /**< Height of the bubble, or 0 to fit. */
+        GdkRGBA     background; /**< Background color and opacity. */
+        GdkRGBA     foreground; /**< Text color. */
+        int         curve;     /**< Curvature of the corners, in pixels. */
+        int         margin[4]; /**< Margins: top, right, bottom, left. */
+        int         time;      /**< Time to display the bubble, in seconds. */
+        int         xpos;      /**< X-offset from the corner of the gravity. */
+        int         ypos;      /**< Y-offset from the corner of the gravity. */
+        std::string gravity;   /**< Corner that the bubble is placed from. */
+        std::string monitor;   /**< Monitor to display the bubble on. */
+        long        count;     /**< Number of times the bubble was sent. */
+        double      progress;  /**< Fraction of the progress bar, from 0 to 1,
+                                    or -1 if there is no bar. */
+    };
+
+    /**
+     * @struct layout
+     * 
+     * @brief Positions and sizes of everything in a notification bubble.
+     */
+    struct layout
+    {
+        PangoLayout* title;  /**< Title text, or NULL. */
+        PangoLayout* body;   /**< Body text, or NULL. */
+        GdkPixbuf*   icon;   /**< Icon, or NULL. */
+        int          width;  /**< Width of the bubble. */
+        int          height; /**< Height of the bubble. */
+        int          iconx;  /**< X-position of the icon. */
+        int          icony;  /**< Y-position of the icon. */
+        int          textx;  /**< X-position of the title and body. */
+        int          texty;  /**< Y-position of the title. */
+        int          titleh; /**< Height of the title. */
+        int          barx;   /**< X-position of the progress bar. */
+        int          bary;   /**< Y-position of the progress bar. */
+        int          barw;   /**< Width of the progress bar, or 0. */
+    };
+
+    /**
+     * @brief Check that the icon of a notification bubble exists.
+     * 
+     * @param[in] path Path to the icon, or empty if there is none.
+     */
+    bool check_icon(const std::string& path);
+
+    /**
+     * @brief Parse the opacity of a notification bubble.
+     * 
+     * @param[in]  opacity The opacity, as it was entered.
+     * @param[out] alpha   The parsed opacity.
+     */
+    bool parse_opacity(const std::string& opacity, double& alpha);
+
+    /**
+     * @brief Resolve the settings of a notification bubble.
+     * 
+     * @param[in]  cli The command line interface.
+     * @param[out] s   The resolved settings.
+     */
+    int resolve(commandline::interface& cli, struct settings& s);
+
+    /**
+     * @brief Lay out a notification bubble.
+     * 
+     * @param[in]  cr The Cairo context that the bubble will be drawn with.
+     * @param[in]  s  The settings of the bubble.
+     * @param[out] l  The layout of the bubble.
+     */
+    int lay_out(cairo_t* cr, const struct settings& s, struct layout& l);
+
+    /**
+     * @brief Estimate the size of a notification bubble, without laying it
+     *        out.
+     * 
+     * @param[in]  s      The settings of the bubble.
+     * @param[out] width  The estimated width.
+     * @param[out] height The estimated height.
+     */
+    void estimate(const struct settings& s, int& width, int& height);
+
+    /**
+     * @brief Draw a notification bubble.
+     * 
+     * @param[in] cr The Cairo context to draw with.
+     * @param[in] s  The settings of the bubble.
+     * @param[in] l  The layout of the bubble.
+     */
+    void draw(cairo_t* cr, const struct settings& s, const struct layout& l);
+
+    /**
+     * @brief Draw the repeat counter of a notification bubble in its top right
+     *        corner.
+     * 
+     * @param[in] cr    The Cairo context to draw with.
+     * @param[in] count Number of times the bubble was sent.
+     * @param[in] width Width of the bubble.
+     * @param[in] curve Curvature of the corners of the bubble.
+     */
+    void draw_badge(cairo_t* cr, long count, int width, int curve);
+
+    /**
+     * @brief Draw a progress bar.
+     * 
+     * @param[in] cr       The Cairo context to draw with.
+     * @param[in] x        X-position of the bar.
+     * @param[in] y        Y-position of the bar.
+     * @param[in] width    Width of the bar.
+     * @param[in] height   Height of the bar.
+     * @param[in] fraction Fraction of the bar that is filled, from 0 to 1.
+     * @param[in] color    Color of the bar.
+     */
+    void draw_bar(cairo_t* cr, double x, double y, double width,
+                  double height, double fraction, const GdkRGBA& color);
+
+    /**
+     * @brief Release the resources held by a layout.
+     * 
+     * @param[in,out] l The layout.
+     */
+    void release(struct layout& l);
+
+    /**
+     * @brief Render a notification bubble to a PNG file, and print the layout
+     *        and draw timings to stderr.
+     * 
+     * @param[in] cli  The command line interface.
+     * @param[in] path Path of the PNG file.
+     */
+    int to_png(commandline::interface& cli, const std::string& path);
+}
+
+ARIA_NAMESPACE_END
+
+#endif /* ARIA_RENDER_HPP */
@@ -20,29 +20,236 @@
 /* Includes */
 #include <cstddef>
 
+/* ************************************************************************** */
+/**
+ * @brief Maximum number of monitors whose geometry is kept in shared memory.
+ */
+#define SHAREDMEM_MONITORS 8
+
+/* ************************************************************************** */
+/**
+ * @brief Number of pixels between notifications in the same stack.
+ */
+#define SHAREDMEM_SPACING 10
+
+/* ************************************************************************** */
+/**
+ * @brief Number of rate limiting buckets in shared memory. The first one is
+ *        shared by all notifications, and the rest are keyed by title.
+ */
+#define SHAREDMEM_BUCKETS 64
+
+/* ************************************************************************** */
+/**
+ * @brief Number of mailboxes that tagged notifications receive updates in.
+ */
+#define SHAREDMEM_MAILBOXES 16
+
+/* ************************************************************************** */
+/**
+ * @brief Sizes (bytes) of the fields of a mailbox, including the terminator.
+ */
+#define SHAREDMEM_TITLE 256
+#define SHAREDMEM_BODY  1024
+#define SHAREDMEM_PATH  512
+
+/* ************************************************************************** */
+/**
+ * @brief Number of recent titles that a summary notification lists.
+ */
+#define SHAREDMEM_SUMMARY 5
+
+/* ************************************************************************** */
+/**
+ * @brief Bits of an ID that hold the PID. The bits above them number the
+ *        notification, when a process displays several, and are 0 otherwise.
+ */
+#define SHAREDMEM_IDSHIFT 32
+#define SHAREDMEM_PID(id) ((long) (id) & ((1L << SHAREDMEM_IDSHIFT) - 1))
+
+/* ************************************************************************** */
+/**
+ * @brief Fields of a mailbox that hold a new value.
+ */
+enum SharedMemField {
+    SHAREDMEM_FIELD_TITLE = 1, /**< New title. */
+    SHAREDMEM_FIELD_BODY  = 2, /**< New body. */
+    SHAREDMEM_FIELD_ICON  = 4  /**< New icon. */
+};
+
+/* ************************************************************************** */
+/**
+ * @brief Urgency of a notification. More urgent notifications are stacked
+ *        closer to the corner of the monitor.
+ */
+enum SharedMemUrgency {
+    SHAREDMEM_URGENCY_LOW      = 0, /**< Low urgency. */
+    SHAREDMEM_URGENCY_NORMAL   = 1, /**< Normal urgency. */
+    SHAREDMEM_URGENCY_CRITICAL = 2  /**< Critical urgency. */
+};
+
+/* ************************************************************************** */
+/**
+ * @brief Corner of the monitor that a stack of notifications grows from.
+ */
+enum SharedMemGravity {
+    SHAREDMEM_TOP_LEFT     = 0, /**< Stack grows down from the top left. */
+    SHAREDMEM_TOP_RIGHT    = 1, /**< Stack grows down from the top right. */
+    SHAREDMEM_BOTTOM_LEFT  = 2, /**< Stack grows up from the bottom left. */
+    SHAREDMEM_BOTTOM_RIGHT = 3  /**< Stack grows up from the bottom right. */
+};
+
+/* ************************************************************************** */
+/**
+ * @brief Position and size of a monitor.
+ */
+struct SharedMemMonitor {
+    long x;       /**< X-coordinate of the monitor. */
+    long y;       /**< Y-coordinate of the monitor. */
+    long w;       /**< Width (px) of the monitor. */
+    long h;       /**< Height (px) of the monitor. */
+    long primary; /**< Non-zero if this is the primary monitor. */
+    long wx;      /**< X-coordinate of the usable area of the monitor. */
+    long wy;      /**< Y-coordinate of the usable area of the monitor. */
+    long ww;      /**< Width (px) of the usable area of the monitor. */
+    long wh;      /**< Height (px) of the usable area of the monitor. */
+};
+
+/* ************************************************************************** */
+/**
+ * @brief Screen geometry, published by the first process that queries it.
+ */
+struct SharedMemGeometry {
+    long timestamp;   /**< RandR configuration timestamp. */
+    long rootw;       /**< Width (px) of the root window. */
+    long rooth;       /**< Height (px) of the root window. */
+    long workarea[4]; /**< _NET_WORKAREA of the current desktop (x, y, w, h). */
+    long nmonitors;   /**< Number of monitors. */
+    struct SharedMemMonitor monitors[SHAREDMEM_MONITORS]; /**< Monitors. */
+};
+
+/* ************************************************************************** */
+/**
+ * @brief New contents for a tagged notification, written by the process that
+ *        replaces it.
+ * 
+ * @details Guarded by a sequence counter, which is odd while a write is in
+ *          progress, the same way as the geometry.
+ */
+struct SharedMemPayload {
+    unsigned long sequence; /**< Sequence counter of the mailbox. */
+    unsigned long tag;      /**< Hash of the tag of the notification. */
+    long id;                /**< ID of the notification it is for. */
+    long fields;            /**< Fields that were set, see SharedMemField. */
+    char title[SHAREDMEM_TITLE]; /**< New title. */
+    char body[SHAREDMEM_BODY];   /**< New body. */
+    char icon[SHAREDMEM_PATH];   /**< Path to the new icon. */
+};
+
+/* ************************************************************************** */
+/**
+ * @brief Notifications that were folded into the summary notification of a
+ *        monitor, because too many were already visible.
+ * 
+ * @details Written under the lock of the table of the monitor, and guarded by
+ *          a sequence counter, which is odd while a write is in progress, so
+ *          that the summary notification can read it without the lock.
+ */
+struct SharedMemSummary {
+    unsigned long sequence; /**< Sequence counter of the summary. */
+    long owner; /**< ID of the summary notification, or 0. */
+    long count; /**< Number of notifications folded into it. */
+    long next;  /**< Index of the title to overwrite next. */
+    char titles[SHAREDMEM_SUMMARY][SHAREDMEM_TITLE]; /**< Recent titles. */
+};
+
+/* ************************************************************************** */
+/**
+ * @brief Header at the start of the shared memory region.
+ * 
+ * @details The header is mapped by every process and read without taking the
+ *          lock. Writes to the geometry are guarded by a sequence counter,
+ *          which is odd while a write is in progress. Each rate limiting
+ *          bucket is a single word, updated with a compare and swap. Processes
+ *          waiting for a full table to have room sleep on its futex. Mailboxes
+ *          are written by one process at a time, and read by the notification
+ *          they are for, as are summaries.
+ */
+struct SharedMemHeader {
+    unsigned long magic;    /**< Identifies the layout of the region. */
+    unsigned long sequence; /**< Sequence counter for the geometry. */
+    struct SharedMemGeometry geometry; /**< Screen geometry. */
+    unsigned long buckets[SHAREDMEM_BUCKETS]; /**< Rate limiting buckets. */
+    unsigned int  freed[SHAREDMEM_MONITORS];  /**< Futex of each table, bumped
+                                                   when an entry is removed. */
+    struct SharedMemPayload mailboxes[SHAREDMEM_MAILBOXES]; /**< Mailboxes. */
+    struct SharedMemSummary summaries[SHAREDMEM_MONITORS];  /**< Summary of
+                                                                 each table. */
+};
+
 /* ************************************************************************** */
 /**
  * @brief Generic data structure to store in the shared memory region.
  */
 struct SharedMemType {
-    long id;   /**< Current process PID. */
+    long id;   /**< ID of the notification, see SHAREDMEM_IDSHIFT. */
     long time; /**< Time of struct creation. */
     long x;    /**< On-screen x coordinate of the notification bubble. */
     long y;    /**< On-screen y coordinate of the notification bubble. */
     long w;    /**< Width (px) of the notification bubble. */
     long h;    /**< Height (px) of the notification bubble. */
+    long monitor; /**< Index of the monitor the notification bubble is on. */
+    long gravity; /**< Gravity of the stack, see SharedMemGravity. */
+    long home;    /**< Requested y coordinate, before being displaced. */
+    unsigned long hash; /**< Hash of the title and body, or 0. */
+    long count;   /**< Number of times the notification was sent. */
+    unsigned long tag; /**< Hash of the tag of the notification, or 0. */
+    long urgency; /**< Urgency of the notification, see SharedMemUrgency. */
 };
 
 /* ************************************************************************** */
 /**
  * @brief Aria notification shared memory handler.
  * 
- * @details Share notification data through a memory mapped region.
+ * @details Share notification data through a memory mapped region. Each
+ *          monitor has its own table, locked independently of the others, so
+ *          that notifications on different monitors do not wait on each other.
 */
 namespace AriaSharedMem
 {
+    const char *           mempath(void);
+    int                    fileopen(int flags);
+    struct SharedMemHeader * header(void);
+    int                    getgeometry(struct SharedMemGeometry *g);
+    int                    setgeometry(struct SharedMemGeometry *g);
+    int                    take(unsigned long key, long interval, long burst);
+    int                    select(long monitor);
     int                    add(struct SharedMemType *data, long shift);
-    int                    remove(void);
+    int                    reserve(struct SharedMemType *data, long shift);
+    int                    commit(struct SharedMemType *data, long shift);
+    int                    cancel(long shift);
+    int                    remove(long shift);
+    int                    lookup(long monitor, long id, struct SharedMemType *data);
+    int                    coalesce(unsigned long hash, long window);
+    int                    deliver(struct SharedMemPayload *p);
+    int                    collect(unsigned long tag, unsigned long *seen,
+                                   struct SharedMemPayload *p);
+    int                    fold(long monitor, long limit, const char *title);
+    int                    summary(long monitor, unsigned long *seen,
+                                   struct SharedMemSummary *s);
+    int                    resign(long monitor);
+    int                    prune(void);
+    int                    isfull(long monitor);
+    int                    claim(long monitor, long urgency);
+    int                    waitfree(long monitor, long urgency, long timeout);
+    int                    evict(long monitor, long shift, long urgency,
+                                  long level);
+    int                    wake(void);
+    int                    notify(void);
+    int                    signal(long id, int sig);
+    long                   self(void);
+    void                   identify(long id);
+    int                    readcomm(const char *path, char *buf, size_t len);
     struct SharedMemType * getfirst(void);
     struct SharedMemType * getlast(void);
     int                    memopen(void);
@@ -56,9 +263,11 @@ namespace AriaSharedMem
     int                    append(struct SharedMemType *data);
     int                    insert(struct SharedMemType *data, size_t index);
     int                    displace(struct SharedMemType *data, long shift);
+    int                    place(struct SharedMemType *data, long shift);
     int                    find(long id);
     int                    findcurrent(void);
     int                    reorder(void);
+    int                    reflow(long shift);
     int                    clear(void);
     int                    clear(size_t index);
     int                    clearcurrent(void);
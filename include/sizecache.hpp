@@ -0,0 +1,84 @@
+/**
+ * @file sizecache.hpp
+ * @author Gabriel Gonzalez
+ * 
+ * @brief Cache of notification bubble sizes, shared between processes.
+ */
+
+#ifndef ARIA_SIZECACHE_HPP
+#define ARIA_SIZECACHE_HPP
+
+#include "aria.hpp"
+#include <cstddef>
+#include <string>
+
+ARIA_NAMESPACE
+
+/**
+ * @namespace sizecache
+ * 
+ * @brief Map the hash of everything that determines the size of a
+ *        notification bubble (text, font, sizes, limits, icon and margins) to
+ *        the size that was measured for it.
+ */
+namespace sizecache
+{
+    /**
+     * @brief Path to the file that holds the cache.
+     */
+    std::string path(void);
+
+    /**
+     * @brief Number of entries in the cache.
+     */
+    const size_t kLength = 256;
+
+    /**
+     * @struct entry
+     * 
+     * @brief A measured size.
+     */
+    struct entry
+    {
+        unsigned long key;   /**< Hash of the notification bubble attributes. */
+        long          width;  /**< Measured width, in pixels. */
+        long          height; /**< Measured height, in pixels. */
+        unsigned long check;  /**< Checksum of the fields above. */
+    };
+
+    /**
+     * @brief Open and map the cache file.
+     */
+    int open(void);
+
+    /**
+     * @brief Look up the size that was measured for a key.
+     * 
+     * @param[in]  key    Hash of the notification bubble attributes.
+     * @param[out] width  The measured width.
+     * @param[out] height The measured height.
+     */
+    int lookup(unsigned long key, int& width, int& height);
+
+    /**
+     * @brief Store the size that was measured for a key.
+     * 
+     * @param[in] key    Hash of the notification bubble attributes.
+     * @param[in] width  The measured width.
+     * @param[in] height The measured height.
+     */
+    int store(unsigned long key, int width, int height);
+
+    /**
+     * @brief Compute the checksum of an entry.
+     * 
+     * @param[in] key    Hash of the notification bubble attributes.
+     * @param[in] width  The measured width.
+     * @param[in] height The measured height.
+     */
+    unsigned long checksum(unsigned long key, long width, long height);
+}
+
+ARIA_NAMESPACE_END
+
+#endif /* ARIA_SIZECACHE_HPP */
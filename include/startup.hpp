@@ -0,0 +1,62 @@
+/**
+ * @file startup.hpp
+ * @author Gabriel Gonzalez
+ *
+ * @brief Startup work that does not depend on the toolkit, run on helper
+ *        threads while it initializes.
+ */
+
+#ifndef ARIA_STARTUP_HPP
+#define ARIA_STARTUP_HPP
+
+#include "aria.hpp"
+#include "commandline.hpp"
+#include <gdk-pixbuf/gdk-pixbuf.h>
+#include <string>
+
+ARIA_NAMESPACE
+
+/**
+ * @namespace startup
+ *
+ * @brief Load the config file, decode the icon, map the shared memory regions,
+ *        and reserve a place in the stack, before they are needed by the
+ *        notification bubble.
+ *
+ * @details Each task only touches state that nothing else uses until join()
+ *          returns, so the tasks can run on their own threads while GTK is
+ *          initialized on the main thread.
+ */
+namespace startup
+{
+    /**
+     * @brief Start the startup tasks.
+     *
+     * @param[in] cli      The command line interface.
+     * @param[in] parallel Whether to run each task on its own thread, instead
+     *                     of one after another on the calling thread.
+     */
+    void begin(commandline::interface& cli, bool parallel);
+
+    /**
+     * @brief Wait for the startup tasks to finish.
+     */
+    void join(void);
+
+    /**
+     * @brief Take the icon that was decoded during startup.
+     *
+     * @param[in] path Path to the icon.
+     */
+    GdkPixbuf* take_icon(const std::string& path);
+
+    /**
+     * @brief Free the icon that was decoded during startup, if it was not
+     *        taken.
+     */
+    void drop_icon(void);
+}
+
+ARIA_NAMESPACE_END
+
+#endif /* ARIA_STARTUP_HPP */
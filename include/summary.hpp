@@ -0,0 +1,54 @@
+/**
+ * @file summary.hpp
+ * @author Gabriel Gonzalez
+ * 
+ * @brief Fold notifications into a single summary notification, when too
+ *        many are visible.
+ */
+
+#ifndef ARIA_SUMMARY_HPP
+#define ARIA_SUMMARY_HPP
+
+#include "aria.hpp"
+#include "commandline.hpp"
+#include "sharedmem.hpp"
+
+ARIA_NAMESPACE
+
+/**
+ * @namespace summary
+ * 
+ * @brief Once more than --max-visible notifications are visible on a monitor,
+ *        new ones are folded into a "+N more" summary notification, listing
+ *        their most recent titles, instead of being displayed on their own.
+ * 
+ * @details The summary is kept in shared memory. The first notification that
+ *          is folded is elected to display it, and the ones after it add to
+ *          the summary and exit, before the toolkit is started.
+ */
+namespace summary
+{
+    /**
+     * @brief Fold the notification into the summary notification of its
+     *        monitor, if too many notifications are visible.
+     * 
+     * @param[in] cli The command line interface.
+     */
+    bool fold(commandline::interface& cli);
+
+    /**
+     * @brief Read the summary, if this process displays it and it changed.
+     * 
+     * @param[out] p The title and body of the summary notification.
+     */
+    bool collect(struct SharedMemPayload& p);
+
+    /**
+     * @brief Stop displaying the summary.
+     */
+    void resign(void);
+}
+
+ARIA_NAMESPACE_END
+
+#endif /* ARIA_SUMMARY_HPP */
@@ -0,0 +1,43 @@
+/**
+ * @file tag.hpp
+ * @author Gabriel Gonzalez
+ * 
+ * @brief Replace the contents of a tagged notification that is on screen.
+ */
+
+#ifndef ARIA_TAG_HPP
+#define ARIA_TAG_HPP
+
+#include "aria.hpp"
+#include "commandline.hpp"
+
+ARIA_NAMESPACE
+
+/**
+ * @namespace tag
+ * 
+ * @brief Hand the title, body, and icon of a notification to the one on
+ *        screen with the same --tag, which updates itself in place, instead of
+ *        displaying another notification bubble.
+ */
+namespace tag
+{
+    /**
+     * @brief Hash the tag of a notification.
+     * 
+     * @param[in] cli The command line interface.
+     */
+    unsigned long key(commandline::interface& cli);
+
+    /**
+     * @brief Hand the notification to the notification on screen with the
+     *        same tag.
+     * 
+     * @param[in] cli The command line interface.
+     */
+    bool forward(commandline::interface& cli);
+}
+
+ARIA_NAMESPACE_END
+
+#endif /* ARIA_TAG_HPP */
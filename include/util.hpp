@@ -6,6 +6,7 @@
  */
 
 #include "aria.hpp"
+#include <pango/pango.h>
 #include <string>
 
 ARIA_NAMESPACE
@@ -17,6 +18,12 @@ ARIA_NAMESPACE
  */
 namespace util
 {
+    /**
+     * @brief Maximum number of characters of a title or body that are laid
+     *        out, whatever the maximum number of lines and width are.
+     */
+    const size_t kMaxChars = 4096;
+
     /**
      * @brief Replace all instances of a subtring in a string.
      * 
@@ -25,6 +32,68 @@ namespace util
      * @param[in]     replace The string to replace the substring with.
      */
     std::string replace_all(std::string& text, std::string find, std::string replace);
+
+    /**
+     * @brief Normalize the title or body text of a notification, in a single
+     *        pass.
+     * 
+     * @param[in] text The text to normalize.
+     */
+    std::string normalize(const std::string& text);
+
+    /**
+     * @brief Cut text down to what can be displayed in a number of lines.
+     * 
+     * @param[in,out] text  The text to truncate.
+     * @param[in]     lines Maximum number of lines. 0 means there is no limit
+     *                      other than kMaxChars.
+     * @param[in]     width Maximum width of a line, in characters. 0 means
+     *                      there is no limit other than kMaxChars.
+     */
+    void truncate(std::string& text, int lines, int width);
+
+    /**
+     * @brief Parse the Pango markup in text, if it contains any.
+     * 
+     * @param[in,out] text  The text to parse.
+     * @param[out]    attrs The attributes of the markup, or NULL.
+     */
+    bool parse_markup(std::string& text, PangoAttrList** attrs);
+
+    /**
+     * @brief Check if the color string is in a hex format.
+     * 
+     * @param[in] color The color string to check.
+     */
+    bool is_hex_color(std::string& color);
+
+    /**
+     * @brief Parse the color string and convert it to a '#123456' string if
+     *        the input is a hex string.
+     * 
+     * @param[in] color The color hex string.
+     */
+    std::string fix_color(std::string& color);
+
+    /**
+     * @brief Hash a string.
+     * 
+     * @param[in] text The string to hash.
+     */
+    unsigned long hash(const std::string& text);
+
+    /**
+     * @brief Current time of a monotonic clock, in milliseconds.
+     */
+    double now(void);
+
+    /**
+     * @brief Print the time elapsed since start, when profiling is enabled.
+     * 
+     * @param[in] label Name of the step that was timed.
+     * @param[in] start Time, from now(), at which the step started.
+     */
+    void profile(const char* label, double start);
 };
 
 ARIA_NAMESPACE_END
@@ -0,0 +1,220 @@
+/**
+ * @file x11bubble.hpp
+ * @author Gabriel Gonzalez
+ * 
+ * @brief The interface for the Aria notification bubble, drawn directly with
+ *        Xlib and Cairo, without GTK.
+ */
+
+#ifndef ARIA_X11BUBBLE_HPP
+#define ARIA_X11BUBBLE_HPP
+
+#include "aria.hpp"
+#include "commandline.hpp"
+#include "progress.hpp"
+#include "render.hpp"
+#include "sharedmem.hpp"
+#include <X11/Xlib.h>
+#include <cairo.h>
+
+ARIA_NAMESPACE
+
+/**
+ * @class x11bubble
+ * 
+ * @brief Control a notification bubble that is an override-redirect window,
+ *        drawn with cairo-xlib and PangoCairo.
+ * 
+ * @details This looks the same as the notification class, and is placed and
+ *          stacked the same way, but skips loading GTK, its theme, and the
+ *          accessibility bridge.
+ */
+class x11bubble
+{
+public:
+    /**
+     * @brief Construct the notification bubble, without connecting to the X
+     *        server yet.
+     */
+    x11bubble();
+
+    /**
+     * @brief Destroy the window and close the connection to the X server.
+     */
+    ~x11bubble();
+
+    /**
+     * @brief Build the notification bubble and set all attributes.
+     * 
+     * @param[in] cli The command line interface, containing all the command
+     *                line information.
+     */
+    int build(commandline::interface& cli);
+
+    /**
+     * @brief Display the notification bubble.
+     */
+    int show(void);
+
+    /**
+     * @brief Handle events until the notification bubble times out, or the
+     *        program is told to quit.
+     */
+    int run(void);
+
+protected:
+    /**
+     * @brief Create the window of the notification bubble.
+     */
+    int create_window(void);
+
+    /**
+     * @brief Set the properties that identify the window as a notification to
+     *        the window manager and compositor.
+     */
+    void set_properties(void);
+
+    /**
+     * @brief Move the notification bubble to the desired position.
+     */
+    void reposition(void);
+
+    /**
+     * @brief Draw the notification bubble.
+     */
+    void redraw(void);
+
+    /**
+     * @brief Draw only the progress bar of the notification bubble.
+     */
+    void redraw_bar(void);
+
+    /**
+     * @brief Display the latest update of the progress bar.
+     */
+    void show_progress(void);
+
+    /**
+     * @brief Handle an event from the X server.
+     * 
+     * @param[in] event The event.
+     */
+    void handle_event(XEvent& event);
+
+    /**
+     * @brief Handle a signal that was received.
+     */
+    void handle_signal(void);
+
+    /**
+     * @brief Replace the title, body, or icon, with new contents that were
+     *        handed to the notification bubble by tag.
+     * 
+     * @param[in] p The new contents.
+     */
+    void replace(const struct SharedMemPayload& p);
+
+private:
+    /**
+     * @brief Connection to the X server.
+     */
+    Display* display_;
+
+    /**
+     * @brief Window of the notification bubble.
+     */
+    Window window_;
+
+    /**
+     * @brief Visual of the window, with an alpha channel if one is available.
+     */
+    Visual* visual_;
+
+    /**
+     * @brief Colormap of the window, or None if the default one is used.
+     */
+    Colormap colormap_;
+
+    /**
+     * @brief Depth of the window.
+     */
+    int depth_;
+
+    /**
+     * @brief Surface that draws to the window.
+     */
+    cairo_surface_t* surface_;
+
+    /**
+     * @brief Attributes of the notification bubble.
+     */
+    struct render::settings settings_;
+
+    /**
+     * @brief Layout of the notification bubble.
+     */
+    struct render::layout layout_;
+
+    /**
+     * @brief Position of the notification bubble on screen.
+     */
+    int x_;
+
+    /**
+     * @brief Position of the notification bubble on screen.
+     */
+    int y_;
+
+    /**
+     * @brief Index of the monitor, and stack, that the notification bubble is
+     *        on.
+     */
+    int index_;
+
+    /**
+     * @brief Hash of the title and body, used to find duplicates of the
+     *        notification bubble in shared memory.
+     */
+    unsigned long key_;
+
+    /**
+     * @brief Hash of the tag of the notification bubble, or 0.
+     */
+    unsigned long tagkey_;
+
+    /**
+     * @brief Urgency of the notification bubble, see SharedMemUrgency.
+     */
+    long urgency_;
+
+    /**
+     * @brief Sequence counter of the contents that were last read from the
+     *        mailbox of the tag.
+     */
+    unsigned long seen_;
+
+    /**
+     * @brief Time, from util::now(), at which the notification bubble times
+     *        out.
+     */
+    double deadline_;
+
+    /**
+     * @brief Source of the progress bar, and the latest update read from it.
+     */
+    struct progress::stream progress_;
+
+    /**
+     * @brief File descriptor that the blocked signals are read from.
+     */
+    int sigfd_;
+
+    /**
+     * @brief Whether the program was told to quit.
+     */
+    bool done_;
+};
+
+ARIA_NAMESPACE_END
+
+#endif /* ARIA_X11BUBBLE_HPP */
@@ -30,9 +30,91 @@
  * -----------------------------------------------------------------------------
  */
 
+#include "coalesce.hpp"
 #include "commandline.hpp"
+#include "config.hpp"
+#include "follow.hpp"
+#include "history.hpp"
 #include "notification.hpp"
+#include "overflow.hpp"
+#include "ratelimit.hpp"
+#include "render.hpp"
+#include "sharedmem.hpp"
+#include "startup.hpp"
+#include "summary.hpp"
+#include "tag.hpp"
+#include "util.hpp"
+#include "x11bubble.hpp"
 #include <gtkmm.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <cerrno>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Hand over, drop, or make room for a notification, before anything is
+ *        started.
+ * 
+ * @param[in] cli The command line interface of the notification.
+ * 
+ * @return -1 if the notification is to be displayed. Otherwise, the exit
+ *         status: 0 if it was handed to a notification on screen, 11 if it
+ *         was dropped by the rate limit, or the status of overflow::admit().
+ */
+static int prepare(commandline::interface& cli)
+{
+    /* Hand the contents to the notification on screen with the same tag. A
+       progress bar is never handed over, as its source is read here */
+    bool handover = !cli.has("render-to") && !cli.has("progress");
+    if (handover && aria::tag::forward(cli))
+    {
+        aria::history::append(cli);
+        return 0;
+    }
+
+    /* Hand a duplicate to the notification on screen */
+    if (handover && aria::coalesce::forward(cli))
+    {
+        aria::history::append(cli);
+        return 0;
+    }
+
+    /* Drop the notification, before anything is started, when too many are
+       being sent */
+    if (!cli.has("render-to") && !aria::ratelimit::allow(cli))
+    {
+        fprintf(stderr, "%s: Too many notifications, dropping this one.\n",
+                PROGRAM);
+        return 11;
+    }
+
+    /* Fold the notification into the summary, when too many are visible */
+    if (handover && aria::summary::fold(cli))
+    {
+        aria::history::append(cli);
+        return 0;
+    }
+
+    /* Wait for, or make, room in the stack, without using the toolkit */
+    int status;
+    if (!cli.has("render-to") && ((status=aria::overflow::admit(cli)) != 0))
+    {
+        return status;
+    }
+
+    /* Record the notification, so that it can be looked up once it is gone */
+    if (!cli.has("render-to"))
+    {
+        aria::history::append(cli);
+    }
+    return -1;
+}
 
 /**
  * @brief Create and display the Aria notification bubble.
@@ -46,6 +128,7 @@ int main(int argc, char** argv)
         {"-h",  "--help",          "",            commandline::no_argument,       "Print program usage."},
         {"-t",  "--title",         "title",       commandline::required_argument, "Title of the notification."},
         {"-b",  "--body",          "body",        commandline::required_argument, "Body of the notification."},
+        {"-p",  "--plain",         "",            commandline::no_argument,       "Display the title and body as plain text, without parsing markup."},
         {"-i",  "--icon",          "path",        commandline::required_argument, "Icon to display next to the text."},
         {"-T",  "--time",          "time",        commandline::required_argument, "Amount of time to display the notification. [Default: 2s]"},
         {"-X",  "--xpos",          "pos",         commandline::required_argument, "X-coordinate of where to put the notification on the screen."},
@@ -53,6 +136,7 @@ int main(int argc, char** argv)
         {"-W",  "--width",         "width",       commandline::required_argument, "Width of the notification."},
         {"-H",  "--height",        "height",      commandline::required_argument, "Height of the notification."},
         {"-g",  "--gravity",       "gravity",     commandline::required_argument, "Location of the origin (0,0) point. [Default: top-right]"},
+        {"-M",  "--monitor",       "monitor",     commandline::required_argument, "Monitor to display the notification on: index, primary, pointer, or focused. [Default: primary]"},
         {"-o",  "--opacity",       "opacity",     commandline::required_argument, "Opacity of the notification. [Default: 0.5]"},
         {"-bg", "--background",    "color",       commandline::required_argument, "Background color. [Default: 0xffa5d0]"},
         {"-fg", "--foreground",    "color",       commandline::required_argument, "Foreground color. [Default: 0xffffff]"},
@@ -66,24 +150,240 @@ int main(int argc, char** argv)
         {"-f",  "--font",          "font",        commandline::required_argument, "Font to display text in. [Default: Dejavu Sans]"},
         {"-ts", "--title-size",    "size",        commandline::required_argument, "Size of title text. [Default: 16]"},
         {"-bs", "--body-size",     "size",        commandline::required_argument, "Size of body text. [Default: 12]"},
+        {"-l",  "--max-lines",     "lines",       commandline::required_argument, "Maximum number of lines of title or body text, before it is ellipsized. [Default: 8]"},
+        {"-w",  "--max-width",     "chars",       commandline::required_argument, "Maximum width of a line of text, in characters. [Default: 60]"},
+        {"-fi", "--fade-in",       "ms",          commandline::required_argument, "Duration of the fade in, in milliseconds. 0 to disable. [Default: 150]"},
+        {"-fo", "--fade-out",      "ms",          commandline::required_argument, "Duration of the fade out, in milliseconds. 0 to disable. [Default: 200]"},
+        {"-sl", "--slide",         "ms",          commandline::required_argument, "Duration of a move to a new position, in milliseconds. 0 to disable. [Default: 200]"},
+        {"-F",  "--frame-stats",   "",            commandline::no_argument,       "Print the number of frames, dropped frames, and draw time of each animation."},
+        {"-L",  "--lean",          "",            commandline::no_argument,       "Start GTK without the accessibility bridge, application registration, or the user's theme."},
+        {"-S",  "--sequential",    "",            commandline::no_argument,       "Run the startup tasks one after another, instead of on helper threads while GTK starts."},
+        {"-B",  "--backend",       "backend",     commandline::required_argument, "Backend to draw the notification with: gtk, or x11 for a lighter one that uses Xlib and Cairo directly. [Default: gtk]"},
+        {"-R",  "--render-to",     "file",        commandline::required_argument, "Render the notification to a PNG file, without a display, and print the layout and draw timings."},
+        {"-O",  "--on-full",       "policy",      commandline::required_argument, "What to do when the stack of notifications is full: drop, wait, or replace-oldest. [Default: wait]"},
+        {"-OT", "--max-wait",      "time",        commandline::required_argument, "Maximum time to wait for room in the stack, in seconds, before the notification is discarded. 0 waits without a limit. [Default: 60]"},
+        {"-u",  "--urgency",       "level",       commandline::required_argument, "Urgency of the notification: low, normal, or critical. More urgent notifications are stacked first, and a critical one closes a less urgent one when the stack is full. [Default: normal]"},
+        {"-tg", "--tag",           "name",        commandline::required_argument, "Replace the title, body, and icon of the notification on screen with the same tag, in place, instead of displaying another."},
+        {"-C",  "--coalesce",      "time",        commandline::required_argument, "Add to the repeat counter of a notification with the same title and body, that was sent within this many seconds, instead of displaying another. 0 to disable. [Default: 10]"},
+        {"-V",  "--max-visible",   "count",       commandline::required_argument, "Maximum number of notifications visible on a monitor. Past it, new ones are folded into a single '+N more' notification that lists their titles. 0 for no limit. [Default: 8]"},
+        {"-P",  "--progress",      "source",      commandline::required_argument, "Display a progress bar, updated from lines of the form 'PERCENT[%] [TEXT]' read from source: - for stdin, or a file or FIFO. The notification stays until the end of the source is reached."},
+        {"-hs", "--history",       "",            commandline::no_argument,       "Print the notifications that were shown, oldest first, and exit."},
+        {"-gr", "--grep",          "pattern",     commandline::required_argument, "With --history, only print the notifications whose title, body, or tag contains pattern."},
+        {"-si", "--since",         "time",        commandline::required_argument, "With --history, only print the notifications shown since time: a duration, e.g. 30m, 2h, or 1d, or a date, e.g. '2024-05-01 09:00'."},
+        {"-fw", "--follow",        "file",        commandline::required_argument, "Watch file, like 'tail -F', and display the lines that are written to it, batching the ones that arrive together into one notification."},
+        {"-re", "--match",         "regex",       commandline::required_argument, "With --follow, only display the lines that match the extended regular expression."},
+        {"-n",  "--next",          "",            commandline::no_argument,       "Start the options of another notification, displayed by the same process, which exits once the last one is gone. It takes the options of the first notification, other than its title, body, icon, tag, progress, and urgency, unless given again."},
     };
 
-    /* Process command line arguments */
+    /* Process command line arguments. Each group of options after --next is
+       another notification */
     commandline::interface cli(options);
-    cli.parse(argv);
-
-    /* Build notification bubble */
-    Glib::RefPtr<Gtk::Application> app = Gtk::Application::create("");
-    aria::notification Aria;
+    std::vector<commandline::interface> rest = cli.parse_groups(argv,
+        "--next", {"title", "body", "icon", "tag", "progress", "urgency"});
     int status;
-    if ((status=Aria.build(cli)) != 0)
+
+    /* Only the first notification is rendered to a file, or shown for each
+       batch of a followed file, and none with the history */
+    const char* single = cli.has("history") ? "history"
+        : cli.has("render-to") ? "render-to"
+        : cli.has("follow") ? "follow" : NULL;
+    if (single && !rest.empty())
+    {
+        fprintf(stderr, "%s: --next is ignored with --%s.\n", PROGRAM, single);
+        rest.clear();
+    }
+
+    /* Print the notifications that were shown, without displaying one */
+    if (cli.has("history"))
+    {
+        return aria::history::print(cli);
+    }
+
+    /* Watch a file, and only carry on, in a child, for each batch of lines
+       that match */
+    if (cli.has("follow") && ((status=aria::follow::run(cli)) >= 0))
     {
         return status;
     }
-    if ((status=Aria.show()) != 0)
+
+    /* Display the other notifications in this process, unless it draws a
+       single bubble without GTK, in which case each one gets a child */
+    std::string backend = cli.get("backend");
+    if (backend.empty())
+    {
+        backend = aria::config::read("backend");
+    }
+    std::vector<commandline::interface*> specs = {&cli};
+    for (auto& next : rest)
+    {
+        pid_t child;
+        if (backend != "x11")
+        {
+            specs.push_back(&next);
+        }
+        else if ((child=fork()) == 0)
+        {
+            specs = {&next};
+            break;
+        }
+        else if (child < 0)
+        {
+            fprintf(stderr, "%s: Unable to start a process for the next "
+                    "notification: %s.\n", PROGRAM, strerror(errno));
+        }
+    }
+
+    /* Hand over, drop, or claim room for each notification, without using
+       the toolkit. Several notifications in one process each get their own ID
+       in shared memory. Once room is claimed, the signals meant for a
+       notification are ignored until it is displayed, as it reads its state
+       when it is placed anyway */
+    std::vector<commandline::interface*> shown;
+    std::vector<long> ids;
+    int result = 0;
+    std::signal(SIGUSR1, SIG_IGN);
+    std::signal(SIGUSR2, SIG_IGN);
+    for (size_t k = 0; k < specs.size(); ++k)
+    {
+        long id = (specs.size() == 1) ? 0
+            : (getpid() | ((long) (k+1) << SHAREDMEM_IDSHIFT));
+        AriaSharedMem::identify(id);
+        if ((status=prepare(*specs[k])) < 0)
+        {
+            shown.push_back(specs[k]);
+            ids.push_back(id);
+        }
+        else if (result == 0)
+        {
+            result = status;
+        }
+    }
+    if (shown.empty())
     {
+        return result;
+    }
+    commandline::interface& first = *shown.front();
+    AriaSharedMem::identify(ids.front());
+
+    /* Skip what a popup notification does not use: the accessibility bridge,
+       GDK backends other than X11, GVfs, and theme lookup, since Adwaita is
+       built into GTK. This is done before the startup threads run, as they
+       read the environment through glib and gdk-pixbuf */
+    bool lean = (backend != "x11") && !first.has("render-to")
+        && (first.has("lean") || (aria::config::read("lean") == "true"));
+    if (lean)
+    {
+        setenv("NO_AT_BRIDGE", "1", 1);
+        setenv("GIO_USE_VFS", "local", 1);
+        setenv("GTK_THEME", "Adwaita", 1);
+        gdk_set_allowed_backends("x11");
+    }
+
+    /* Load the config, decode the icon, and map shared memory, while the
+       toolkit starts */
+    double start = aria::util::now();
+    aria::startup::begin(first, !first.has("sequential"));
+
+    /* Render notification bubble without a display */
+    if (first.has("render-to"))
+    {
+        aria::startup::join();
+        aria::startup::drop_icon();
+        return aria::render::to_png(first, first.get("render-to"));
+    }
+
+    /* Build notification bubble without GTK, and wait for the children that
+       display the others */
+    if (backend == "x11")
+    {
+        aria::startup::join();
+        aria::startup::drop_icon();
+        aria::x11bubble bubble;
+        if (((status=bubble.build(first)) != 0)
+            || ((status=bubble.show()) != 0))
+        {
+            return status;
+        }
+        status = bubble.run();
+        while (wait(NULL) > 0)
+        {
+        }
         return status;
     }
 
-    return app->run(Aria);
+    /* Start GTK */
+    Glib::RefPtr<Gtk::Application> app;
+    std::unique_ptr<Gtk::Main> kit;
+    if (lean)
+    {
+        /* GTK exits when it can not open the display, so open it first, and
+           wait for the startup threads before giving up */
+        if (!gtk_init_check(&argc, &argv))
+        {
+            aria::startup::join();
+            fprintf(stderr, "%s: Unable to connect to the X server.\n",
+                    PROGRAM);
+            return 10;
+        }
+        kit.reset(new Gtk::Main(argc, argv));
+    }
+    else
+    {
+        app = Gtk::Application::create("");
+    }
+    aria::util::profile("init", start);
+    aria::startup::join();
+    aria::util::profile("ready", start);
+
+    /* Build notification bubbles. One that can not be built is skipped, so
+       that the others are still displayed */
+    std::vector<std::unique_ptr<aria::notification>> bubbles;
+    for (size_t k = 0; k < shown.size(); ++k)
+    {
+        std::unique_ptr<aria::notification> bubble(new aria::notification);
+        AriaSharedMem::identify(ids[k]);
+        if (((status=bubble->build(*shown[k])) != 0)
+            || ((status=bubble->show()) != 0))
+        {
+            result = (result != 0) ? result : status;
+            continue;
+        }
+        bubbles.push_back(std::move(bubble));
+    }
+    aria::startup::drop_icon();
+    if (bubbles.empty())
+    {
+        return result;
+    }
+    bubbles.front()->signal_map().connect(
+        sigc::bind(sigc::ptr_fun(&aria::util::profile), "map", start));
+
+    /* Run until the last notification bubble is hidden */
+    if (lean)
+    {
+        size_t visible = bubbles.size();
+        for (auto& bubble : bubbles)
+        {
+            bubble->signal_hide().connect([&visible]() {
+                if (--visible == 0)
+                {
+                    Gtk::Main::quit();
+                }
+            });
+            bubble->Gtk::Widget::show();
+        }
+        Gtk::Main::run();
+        return result;
+    }
+    Gtk::Application* application = app.get();
+    for (size_t k = 1; k < bubbles.size(); ++k)
+    {
+        aria::notification* bubble = bubbles[k].get();
+        app->signal_activate().connect([application, bubble]() {
+            application->add_window(*bubble);
+            bubble->Gtk::Widget::show();
+        });
+    }
+    status = app->run(*bubbles.front());
+    return (status != 0) ? status : result;
 }
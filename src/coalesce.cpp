@@ -0,0 +1,71 @@
+/**
+ * @file coalesce.cpp
+ * @author Gabriel Gonzalez
+ * 
+ * @brief Coalesce duplicate notifications into the one that is on screen.
+ */
+
+#include "coalesce.hpp"
+#include "config.hpp"
+#include "sharedmem.hpp"
+#include "util.hpp"
+#include <cstdlib>
+#include <string>
+
+ARIA_NAMESPACE
+
+/**
+ * @brief Hash the title and body of a notification.
+ * 
+ * @details The title and body are taken from the command line, or the config
+ *          file if not given, as they are before being normalized, so that
+ *          every process computes the same hash without laying out any text.
+ * 
+ * @param[in] cli The command line interface.
+ * 
+ * @return The hash, which is never 0.
+ */
+unsigned long coalesce::key(commandline::interface& cli)
+{
+    std::string title = cli.get("title");
+    std::string body = cli.get("body");
+    if (title.empty())
+    {
+        title = config::read("title");
+    }
+    if (body.empty())
+    {
+        body = config::read("body");
+    }
+    unsigned long hash = util::hash(title + '\x1f' + body);
+    return (hash != 0) ? hash : 1;
+}
+
+/**
+ * @brief Hand the notification to a notification on screen with the same
+ *        title and body.
+ * 
+ * @details Only a notification that was last sent within the coalescing
+ *          window, in seconds, is matched. A window of 0 disables coalescing.
+ * 
+ * @param[in] cli The command line interface.
+ * 
+ * @return True if the notification was handed over, in which case there is
+ *         nothing left to display, and false otherwise.
+ */
+bool coalesce::forward(commandline::interface& cli)
+{
+    std::string window = cli.get("coalesce");
+    if (window.empty())
+    {
+        window = config::read("coalesce");
+    }
+    long seconds = std::strtol(window.c_str(), NULL, 10);
+    if (seconds <= 0)
+    {
+        return false;
+    }
+    return AriaSharedMem::coalesce(coalesce::key(cli), seconds) == 0;
+}
+
+ARIA_NAMESPACE_END
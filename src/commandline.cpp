@@ -71,6 +71,64 @@ namespace commandline
         }
     }
 
+    /**
+     * @details Split the argument list at each separator, keeping the program
+     *          name at the start of each group, so that each group can be
+     *          parsed like a whole command line.
+     */
+    std::vector<interface> interface::parse_groups(char** argv,
+                                                   std::string separator,
+                                                   std::vector<std::string> own)
+    {
+        const option_t*                 sep = this->find_option(separator);
+        std::vector<std::vector<char*>> groups(1, {argv[0]});
+        std::vector<interface>          rest;
+
+        for (char** argp = argv+1; *argp != NULL; ++argp)
+        {
+            if (sep && ((*argp == sep->shortopt) || (*argp == sep->longopt)))
+            {
+                groups.push_back({argv[0]});
+            }
+            else
+            {
+                groups.back().push_back(*argp);
+            }
+        }
+
+        for (auto& key : own)
+        {
+            key = this->to_key(key);
+        }
+        for (auto& group : groups)
+        {
+            if (group.size() == 1)
+            {
+                continue;
+            }
+            group.push_back(NULL);
+            if (&group == &groups.front())
+            {
+                this->parse(group.data());
+                continue;
+            }
+
+            rest.emplace_back(this->m_options);
+            interface& cli = rest.back();
+            cli.parse(group.data());
+            for (const auto& it : this->m_table)
+            {
+                if ((cli.m_table.find(it.first) == cli.m_table.end())
+                    && (std::find(own.begin(), own.end(), it.first)
+                        == own.end()))
+                {
+                    cli.m_table.insert(it);
+                }
+            }
+        }
+        return rest;
+    }
+
     /**
      * @details Used as a test to make sure that command line options were
      *          interpretted correctly. If there is ever any doubt, this
@@ -159,7 +217,7 @@ namespace commandline
         {
         case commandline::no_argument:
             this->parse_help_option(data);
-            return argp;
+            break;
         case commandline::list_argument:
             listflag = true;
             if (!*(argp+1))
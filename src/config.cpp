@@ -20,6 +20,7 @@
 #include <string>
 #include <cstdlib>
 #include <cstring>
+#include <mutex>
 
 /*
  *
@@ -31,8 +32,38 @@
 
 ARIA_NAMESPACE
 
+/**
+ * The parsed config file, shared by every read
+ */
+static GKeyFile* KEYFILE = NULL;
+
+/**
+ * Whether the config file has been parsed
+ */
+static std::once_flag LOADED;
+
+/**
+ * Parse the config file into KEYFILE
+ */
+static void load_key_file(void)
+{
+    if (config::new_key_file(&KEYFILE, ARIA_CONFIG_FILE) < 0) {
+        KEYFILE = NULL;
+    }
+}
+
 namespace config
 {
+    /**
+     * Parse the config file, only the first time this is called, and return
+     * it. This is safe to call from several threads at once.
+     */
+    GKeyFile* load(void)
+    {
+        std::call_once(LOADED, &load_key_file);
+        return KEYFILE;
+    }
+
     /**
      * Read the configuration file and return the key value as a string 
      */
@@ -42,7 +73,7 @@ namespace config
         GKeyFile* keyfile;
         char* value;
 
-        if (config::new_key_file(&keyfile, ARIA_CONFIG_FILE) < 0) {
+        if (!(keyfile=config::load())) {
             return "";
         }
 
@@ -52,7 +83,9 @@ namespace config
             return "";
         }
 
-        return std::string(value);
+        std::string result(value);
+        g_free(value);
+        return result;
     }
 
     /**
@@ -73,7 +106,7 @@ namespace config
         GKeyFile* keyfile;
         char* value;
 
-        if (config::new_key_file(&keyfile, ARIA_CONFIG_FILE) < 0) {
+        if (!(keyfile=config::load())) {
             return "";
         }
 
@@ -83,7 +116,9 @@ namespace config
             return "";
         }
 
-        return std::string(value);
+        std::string result(value);
+        g_free(value);
+        return result;
     }
 
     /**
@@ -95,7 +130,7 @@ namespace config
         GKeyFile* keyfile;
         gint read;
 
-        if (config::new_key_file(&keyfile, ARIA_CONFIG_FILE) < 0) {
+        if (!(keyfile=config::load())) {
             return -1;
         }
 
@@ -117,7 +152,7 @@ namespace config
         GKeyFile* keyfile;
         gboolean read;
 
-        if (config::new_key_file(&keyfile, ARIA_CONFIG_FILE) < 0) {
+        if (!(keyfile=config::load())) {
             return -1;
         }
 
@@ -159,7 +194,7 @@ namespace config
         size_t length;
         std::vector<std::string> groupvec;
 
-        if (config::new_key_file(&keyfile, ARIA_CONFIG_FILE) < 0) {
+        if (!(keyfile=config::load())) {
             return groupvec;
         }
 
@@ -180,7 +215,7 @@ namespace config
         size_t length;
         std::vector<std::string> keyvec;
 
-        if (config::new_key_file(&keyfile, ARIA_CONFIG_FILE) < 0) {
+        if (!(keyfile=config::load())) {
             return keyvec;
         }
 
@@ -0,0 +1,447 @@
+/**
+ * @file follow.cpp
+ * @author Gabriel Gonzalez
+ * 
+ * @brief Watch a file, and display the lines written to it that match a
+ *        pattern.
+ */
+
+#include "follow.hpp"
+#include "util.hpp"
+#include <fcntl.h>
+#include <poll.h>
+#include <regex.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/inotify.h>
+#include <sys/stat.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+ARIA_NAMESPACE
+
+/**
+ * @brief Maximum length of a line that is kept. Anything past it is dropped.
+ */
+static const size_t kLineLength = 4096;
+
+/**
+ * @brief Add a matching line to the batch.
+ * 
+ * @param[in,out] b     The batch.
+ * @param[in]     begin Start of the line.
+ * @param[in]     end   End of the line, without the line break.
+ */
+static void add_line(struct follow::batch& b, const char* begin,
+                     const char* end)
+{
+    if ((end > begin) && (end[-1] == '\r'))
+    {
+        --end;
+    }
+    if (end == begin)
+    {
+        return;
+    }
+    if (b.count == 0)
+    {
+        b.deadline = util::now() + follow::kBatchTime;
+    }
+    if (b.lines.size() == follow::kBatchLines)
+    {
+        b.lines.pop_front();
+    }
+    b.lines.emplace_back(begin, std::min((size_t) (end-begin), kLineLength));
+    ++b.count;
+}
+
+/**
+ * @brief Search complete lines for the pattern, and add the ones that match
+ *        to the batch.
+ * 
+ * @details The pattern is run over all of the lines at once, and it is
+ *          compiled with REG_NEWLINE, so that a match can not span lines. Only
+ *          the lines that match are looked at on their own, to find where
+ *          they start and end.
+ * 
+ * @param[in]     re    The pattern, or NULL to match every line.
+ * @param[in]     begin Start of the lines.
+ * @param[in]     end   End of the lines, just past the last line break. It
+ *                      must point to a null character.
+ * @param[in,out] b     The batch.
+ */
+static void scan(const regex_t* re, const char* begin, const char* end,
+                 struct follow::batch& b)
+{
+    const char* p = begin;
+    regmatch_t match;
+    while (p < end)
+    {
+        const char* start = p;
+        if (re)
+        {
+            if (regexec(re, p, 1, &match, 0) != 0)
+            {
+                break;
+            }
+            start = p + match.rm_so;
+            const char* brk = (const char*) memrchr(p, '\n', start-p);
+            start = brk ? brk+1 : p;
+        }
+        const char* eol = (const char*) memchr(start, '\n', end-start);
+        if (!eol)
+        {
+            eol = end;
+        }
+        add_line(b, start, eol);
+        p = eol + 1;
+    }
+}
+
+/**
+ * @brief Read what was appended to the file, and add the lines that match to
+ *        the batch.
+ * 
+ * @details The file is read in chunks as large as a pipe buffer, and each
+ *          chunk is searched where it was read, only the line that spans two
+ *          chunks is copied. A file that got shorter was truncated, e.g. by
+ *          "logrotate copytruncate", and is read again from the start.
+ * 
+ * @param[in,out] src The file.
+ * @param[in]     re  The pattern, or NULL to match every line.
+ * @param[in,out] b   The batch.
+ */
+static void read_file(struct follow::source& src, const regex_t* re,
+                      struct follow::batch& b)
+{
+    char buf[65536+1];
+    struct stat statbuf;
+    ssize_t n;
+    if (src.fd < 0)
+    {
+        return;
+    }
+    if ((fstat(src.fd, &statbuf) == 0)
+        && (statbuf.st_size < lseek(src.fd, 0, SEEK_CUR)))
+    {
+        lseek(src.fd, 0, SEEK_SET);
+        src.partial.clear();
+    }
+
+    while ((n=::read(src.fd, buf, sizeof(buf)-1)) > 0)
+    {
+        char* end = buf + n;
+        for (char* z = buf; (z=(char*) memchr(z, '\0', end-z)); ++z)
+        {
+            *z = ' ';
+        }
+        char* first = (char*) memchr(buf, '\n', n);
+        if (!first)
+        {
+            src.partial.append(buf, std::min((size_t) n, kLineLength
+                                             - std::min(src.partial.size(),
+                                                        kLineLength)));
+            continue;
+        }
+        char* last = (char*) memrchr(first, '\n', end-first);
+
+        /* Line that spans the previous chunk */
+        src.partial.append(buf, std::min((size_t) (first-buf+1), kLineLength
+                                         - std::min(src.partial.size(),
+                                                    kLineLength)));
+        if (src.partial.back() != '\n')
+        {
+            src.partial += '\n';
+        }
+        scan(re, src.partial.c_str(),
+             src.partial.c_str() + src.partial.size(), b);
+
+        /* Lines in this chunk */
+        src.partial.assign(last+1, std::min((size_t) (end-last-1),
+                                            kLineLength));
+        last[1] = '\0';
+        scan(re, first+1, last+1, b);
+    }
+}
+
+/**
+ * @brief Open the file, and watch it.
+ * 
+ * @param[in,out] src  The file.
+ * @param[in]     tail Whether to start at the end of the file, or at the
+ *                     start, for a file that was created after a rotation.
+ * 
+ * @return 0 on success, and -1 if the file can not be opened.
+ */
+static int open_file(struct follow::source& src, bool tail)
+{
+    struct stat statbuf;
+    if ((src.fd=::open(src.path.c_str(), O_RDONLY | O_CLOEXEC)) < 0)
+    {
+        return -1;
+    }
+    if (fstat(src.fd, &statbuf) < 0)
+    {
+        ::close(src.fd);
+        src.fd = -1;
+        return -1;
+    }
+    if (tail)
+    {
+        lseek(src.fd, 0, SEEK_END);
+    }
+    src.inode  = statbuf.st_ino;
+    src.filewd = inotify_add_watch(src.inotify, src.path.c_str(),
+                                   IN_MODIFY | IN_ATTRIB | IN_MOVE_SELF
+                                   | IN_DELETE_SELF);
+    src.partial.clear();
+    return 0;
+}
+
+/**
+ * @brief Stop watching the file, and close it.
+ * 
+ * @param[in,out] src The file.
+ */
+static void close_file(struct follow::source& src)
+{
+    if (src.filewd >= 0)
+    {
+        inotify_rm_watch(src.inotify, src.filewd);
+    }
+    if (src.fd >= 0)
+    {
+        ::close(src.fd);
+    }
+    src.filewd = -1;
+    src.fd = -1;
+}
+
+/**
+ * @brief Switch to the file that is now at the path, after a rotation.
+ * 
+ * @details What was left in the old file is read first, so that lines written
+ *          just before it was moved are not lost.
+ * 
+ * @param[in,out] src The file.
+ * @param[in]     re  The pattern, or NULL to match every line.
+ * @param[in,out] b   The batch.
+ */
+static void reopen_file(struct follow::source& src, const regex_t* re,
+                        struct follow::batch& b)
+{
+    struct stat statbuf;
+    if ((stat(src.path.c_str(), &statbuf) < 0)
+        || ((src.fd >= 0) && (statbuf.st_ino == src.inode)))
+    {
+        return;
+    }
+    read_file(src, re, b);
+    close_file(src);
+    if (open_file(src, false) == 0)
+    {
+        read_file(src, re, b);
+    }
+}
+
+/**
+ * @brief Set the title and body of the notification from a batch.
+ * 
+ * @details The title is the name of the file, unless one was given, and the
+ *          body the most recent matching lines, as plain text, since log
+ *          lines are not markup.
+ * 
+ * @param[in,out] cli  The command line interface.
+ * @param[in]     src  The file.
+ * @param[in]     b    The batch.
+ */
+static void compose(commandline::interface& cli,
+                    const struct follow::source& src,
+                    const struct follow::batch& b)
+{
+    std::string body;
+    if (b.count > b.lines.size())
+    {
+        body = "+" + std::to_string(b.count - b.lines.size())
+            + " more\n";
+    }
+    for (const std::string& line : b.lines)
+    {
+        body += line;
+        body += '\n';
+    }
+    body.pop_back();
+    if (!cli.has("title"))
+    {
+        cli.set("title", (b.count > 1)
+                ? src.name + " (" + std::to_string(b.count) + " matches)"
+                : src.name);
+    }
+    cli.set("body", body);
+    if (!cli.has("plain"))
+    {
+        cli.set("plain", "");
+    }
+}
+
+/**
+ * @brief Watch the file, and fork a child to display each batch of matching
+ *        lines.
+ * 
+ * @details The file is followed by name, like "tail -F": reading starts at its
+ *          end, and it is switched to a new file at the same path once it is
+ *          rotated, or created, if it does not exist yet. The watcher only
+ *          wakes up when the file changes, or when a batch is due.
+ * 
+ *          The child returns with the title and body set from the batch, and
+ *          displays them as if they were given on the command line, so that
+ *          tags, coalescing, rate limiting, and the history all apply to it.
+ *          The watcher itself never starts the toolkit, so only the batches,
+ *          and not the lines, pay for its startup.
+ * 
+ * @param[in,out] cli The command line interface.
+ * 
+ * @return -1 in the child, which displays the batch. Otherwise, the watcher
+ *         only returns on error, with 15.
+ */
+int follow::run(commandline::interface& cli)
+{
+    char events[4096]
+        __attribute__((aligned(__alignof__(struct inotify_event))));
+    struct follow::source src;
+    struct follow::batch b;
+    regex_t compiled;
+    regex_t* re = NULL;
+    std::string pattern = cli.get("match");
+    std::string dir;
+    size_t slash;
+    int status;
+    if (cli.has("body"))
+    {
+        fprintf(stderr, "%s: --body can not be used with --follow.\n", PROGRAM);
+        return 15;
+    }
+    if (!pattern.empty())
+    {
+        if ((status=regcomp(&compiled, pattern.c_str(),
+                            REG_EXTENDED | REG_NEWLINE)) != 0)
+        {
+            char msg[256];
+            regerror(status, &compiled, msg, sizeof(msg));
+            fprintf(stderr, "%s: Invalid pattern '%s': %s.\n", PROGRAM,
+                    pattern.c_str(), msg);
+            return 15;
+        }
+        re = &compiled;
+    }
+
+    src.path    = cli.get("follow");
+    slash       = src.path.rfind('/');
+    src.name    = (slash == std::string::npos) ? src.path
+        : src.path.substr(slash+1);
+    dir         = (slash == std::string::npos) ? "."
+        : (slash == 0) ? "/" : src.path.substr(0, slash);
+    src.filewd  = -1;
+    src.fd      = -1;
+    src.inode   = 0;
+    b.count     = 0;
+    b.deadline  = 0;
+    if (((src.inotify=inotify_init1(IN_NONBLOCK | IN_CLOEXEC)) < 0)
+        || ((src.dirwd=inotify_add_watch(src.inotify, dir.c_str(),
+                                         IN_CREATE | IN_MOVED_TO)) < 0))
+    {
+        fprintf(stderr, "%s: Unable to watch '%s': %s.\n", PROGRAM,
+                src.path.c_str(), strerror(errno));
+        return 15;
+    }
+    open_file(src, true);
+
+    /* Children that display a batch are not waited for */
+    signal(SIGCHLD, SIG_IGN);
+    while (true)
+    {
+        struct pollfd pfd = {src.inotify, POLLIN, 0};
+        int timeout = -1;
+        if (b.count > 0)
+        {
+            timeout = std::max(0, (int) (b.deadline - util::now()) + 1);
+        }
+        if ((poll(&pfd, 1, timeout) < 0) && (errno != EINTR))
+        {
+            fprintf(stderr, "%s: Unable to watch '%s': %s.\n", PROGRAM,
+                    src.path.c_str(), strerror(errno));
+            return 15;
+        }
+
+        if (pfd.revents & POLLIN)
+        {
+            bool modified = false;
+            bool rotated = false;
+            ssize_t n;
+            while ((n=::read(src.inotify, events, sizeof(events))) > 0)
+            {
+                for (char* p = events; p < events+n;
+                     p += sizeof(struct inotify_event)
+                         + ((struct inotify_event*) p)->len)
+                {
+                    struct inotify_event* e = (struct inotify_event*) p;
+                    if (e->wd == src.dirwd)
+                    {
+                        rotated = rotated || (src.name == e->name);
+                    }
+                    else if (e->wd == src.filewd)
+                    {
+                        modified = modified || (e->mask & IN_MODIFY);
+                        rotated  = rotated || !(e->mask & IN_MODIFY);
+                        if (e->mask & IN_IGNORED)
+                        {
+                            src.filewd = -1;
+                        }
+                    }
+                }
+            }
+            if (modified)
+            {
+                read_file(src, re, b);
+            }
+            if (rotated)
+            {
+                reopen_file(src, re, b);
+            }
+        }
+
+        if ((b.count > 0) && (util::now() >= b.deadline))
+        {
+            pid_t pid = fork();
+            if (pid == 0)
+            {
+                /* The inotify instance is shared with the watcher, so its
+                   watches are left alone */
+                signal(SIGCHLD, SIG_DFL);
+                if (src.fd >= 0)
+                {
+                    ::close(src.fd);
+                }
+                ::close(src.inotify);
+                if (re)
+                {
+                    regfree(re);
+                }
+                compose(cli, src, b);
+                return -1;
+            }
+            else if (pid < 0)
+            {
+                fprintf(stderr, "%s: Unable to display %lu lines: %s.\n",
+                        PROGRAM, b.count, strerror(errno));
+            }
+            b.lines.clear();
+            b.count = 0;
+        }
+    }
+}
+
+ARIA_NAMESPACE_END
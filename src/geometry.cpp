@@ -0,0 +1,826 @@
+/**
+ * @file geometry.cpp
+ * @author Gabriel Gonzalez
+ * 
+ * @brief Monitor geometry of the X screen.
+ */
+
+#include "geometry.hpp"
+#include "sharedmem.hpp"
+#include <X11/Xlib.h>
+#include <X11/Xatom.h>
+#include <X11/extensions/Xrandr.h>
+#include <gdk/gdkx.h>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+
+ARIA_NAMESPACE
+
+/**
+ * @brief The cached monitor geometry.
+ */
+static geometry::monitorlist_t MONITORS;
+
+/**
+ * @brief The cached work area of the current desktop.
+ */
+static struct geometry::area WORKAREA;
+
+/**
+ * @brief Whether the cached monitor geometry can be used.
+ */
+static bool VALID = false;
+
+/**
+ * @brief Retrieve the geometry of each monitor.
+ * 
+ * @details The geometry is retrieved once and kept for the lifetime of the
+ *          process. It is only retrieved again after invalidate() is called,
+ *          when the X server reports that the monitor layout changed.
+ * 
+ *          The geometry published in shared memory by an earlier process is
+ *          used when the root window still has the same size, and neither the
+ *          RandR configuration nor the work area has changed since, which
+ *          takes a few requests. Otherwise, the X server is queried, and the result is published for
+ *          the processes that come after.
+ * 
+ * @param[in]  display  An open connection to the X server.
+ * @param[out] monitors The list of monitors.
+ * 
+ * @return 0 on success. See query() for other return values.
+ */
+int geometry::get(Display* display, monitorlist_t& monitors)
+{
+    int status;
+    if (!VALID)
+    {
+        if ((geometry::load(display) < 0)
+            && ((status=geometry::query(display)) < 0))
+        {
+            return status;
+        }
+        VALID = true;
+    }
+    monitors = MONITORS;
+    return 0;
+}
+
+/**
+ * @brief Select a monitor.
+ * 
+ * @details The monitor can be selected by its index, or as the primary
+ *          monitor, the monitor with the mouse pointer, or the monitor with
+ *          the focused window. If the monitor can not be determined, the
+ *          primary monitor is selected.
+ * 
+ * @param[in]  display An open connection to the X server.
+ * @param[in]  which   The monitor to select: its index, "primary", "pointer",
+ *                     or "focused".
+ * @param[out] index   Index of the selected monitor.
+ * @param[out] monitor The selected monitor.
+ * 
+ * @return 0 on success. See get() for other return values.
+ */
+int geometry::select(Display* display, const std::string& which, int& index,
+                     struct monitor& monitor)
+{
+    monitorlist_t monitors;
+    char* end;
+    int status;
+    int x;
+    int y;
+    if ((status=geometry::get(display, monitors)) < 0)
+    {
+        return status;
+    }
+
+    index = -1;
+    if (which == "pointer")
+    {
+        if (geometry::get_pointer(display, x, y) == 0)
+        {
+            index = geometry::find(monitors, x, y);
+        }
+    }
+    else if (which == "focused")
+    {
+        if (geometry::get_focused(display, x, y) == 0)
+        {
+            index = geometry::find(monitors, x, y);
+        }
+    }
+    else if (!which.empty() && (which != "primary"))
+    {
+        index = strtol(which.c_str(), &end, 10);
+        if (*end || (index < 0) || (index >= (int) monitors.size()))
+        {
+            fprintf(stderr, "%s: Invalid monitor '%s'.\n", PROGRAM,
+                    which.c_str());
+            index = -1;
+        }
+    }
+    if (index < 0)
+    {
+        index = geometry::find_primary(monitors);
+    }
+    monitor = monitors[index];
+    return 0;
+}
+
+/**
+ * @brief Find the monitor that contains a point.
+ * 
+ * @param[in] monitors The list of monitors.
+ * @param[in] x        X-coordinate of the point.
+ * @param[in] y        Y-coordinate of the point.
+ * 
+ * @return Index of the monitor, or -1 if no monitor contains the point.
+ */
+int geometry::find(const monitorlist_t& monitors, int x, int y)
+{
+    size_t i;
+    for (i=0; i < monitors.size(); ++i)
+    {
+        const struct monitor& m = monitors[i];
+        if ((x >= m.x) && (x < m.x+m.width) && (y >= m.y)
+            && (y < m.y+m.height))
+        {
+            return i;
+        }
+    }
+    return -1;
+}
+
+/**
+ * @brief Find the primary monitor.
+ * 
+ * @param[in] monitors The list of monitors.
+ * 
+ * @return Index of the primary monitor. If no monitor is marked as primary,
+ *         this is the monitor at x=0, or the first monitor.
+ */
+int geometry::find_primary(const monitorlist_t& monitors)
+{
+    size_t i;
+    int index = 0;
+    for (i=0; i < monitors.size(); ++i)
+    {
+        if (monitors[i].primary)
+        {
+            return i;
+        }
+        if ((monitors[i].x == 0) && (index == 0))
+        {
+            index = i;
+        }
+    }
+    return index;
+}
+
+/**
+ * @brief Guess the monitor that a notification bubble will be displayed on,
+ *        before connecting to the X server.
+ * 
+ * @details A monitor that can only be found once connected to the X server,
+ *          i.e. "pointer" or "focused", is guessed to be the primary one.
+ * 
+ * @param[in] spec     The monitor option: an index, "primary", "pointer", or
+ *                     "focused".
+ * @param[in] monitors The list of monitors.
+ * 
+ * @return Index of the monitor.
+ */
+int geometry::guess(const std::string& spec, const monitorlist_t& monitors)
+{
+    char* end;
+    long index = strtol(spec.c_str(), &end, 10);
+    if (spec.empty() || *end || (index < 0)
+        || (index >= (long) monitors.size()))
+    {
+        return geometry::find_primary(monitors);
+    }
+    return index;
+}
+
+/**
+ * @brief Determine the position of the mouse pointer.
+ * 
+ * @param[in]  display An open connection to the X server.
+ * @param[out] x       X-coordinate of the pointer.
+ * @param[out] y       Y-coordinate of the pointer.
+ * 
+ * @return 0 on success, and -1 if the pointer is on another screen.
+ */
+int geometry::get_pointer(Display* display, int& x, int& y)
+{
+    Window root;
+    Window child;
+    int wx;
+    int wy;
+    unsigned int mask;
+    if (!XQueryPointer(display, DefaultRootWindow(display), &root, &child, &x,
+                       &y, &wx, &wy, &mask))
+    {
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * @brief Determine the center of the focused window.
+ * 
+ * @details The focused window is the one the window manager sets as
+ *          _NET_ACTIVE_WINDOW.
+ * 
+ * @param[in]  display An open connection to the X server.
+ * @param[out] x       X-coordinate of the center of the window.
+ * @param[out] y       Y-coordinate of the center of the window.
+ * 
+ * @return 0 on success, and -1 if there is no focused window.
+ */
+int geometry::get_focused(Display* display, int& x, int& y)
+{
+    std::vector<long> active;
+    Window root = DefaultRootWindow(display);
+    Window window;
+    Window child;
+    int wx;
+    int wy;
+    unsigned int width;
+    unsigned int height;
+    unsigned int border;
+    unsigned int depth;
+    if ((geometry::get_property(display, root, "_NET_ACTIVE_WINDOW", active,
+                                XA_WINDOW) < 0)
+        || !(window=active[0])
+        || !XGetGeometry(display, window, &child, &wx, &wy, &width, &height,
+                         &border, &depth)
+        || !XTranslateCoordinates(display, window, root, 0, 0, &x, &y, &child))
+    {
+        return -1;
+    }
+    x += width / 2;
+    y += height / 2;
+    return 0;
+}
+
+/**
+ * @brief Retrieve the work area of the current desktop.
+ * 
+ * @param[in]  display  An open connection to the X server.
+ * @param[out] workarea The work area. If the window manager does not set one,
+ *                      this is the whole root window.
+ * 
+ * @return 0 on success. See query() for other return values.
+ */
+int geometry::get_workarea(Display* display, struct area& workarea)
+{
+    monitorlist_t monitors;
+    int status;
+    if ((status=geometry::get(display, monitors)) < 0)
+    {
+        return status;
+    }
+    workarea = WORKAREA;
+    return 0;
+}
+
+/**
+ * @brief Load the geometry that was published in shared memory.
+ * 
+ * @param[in] display An open connection to the X server.
+ * 
+ * @details Monitors can be rearranged or swapped without changing the size of
+ *          the root window, so the RandR configuration timestamp is compared
+ *          as well. A panel or dock that starts, moves, or exits changes
+ *          neither, and the process that published the geometry may have
+ *          exited before it could see the change, so the work area is read
+ *          and compared too.
+ * 
+ * @return 0 on success, and -1 if nothing was published, or if the root window
+ *         size, the RandR configuration, or the work area no longer matches.
+ */
+int geometry::load(Display* display)
+{
+    struct SharedMemGeometry g;
+    struct area workarea;
+    int screen;
+    if (!display || (AriaSharedMem::getgeometry(&g) < 0))
+    {
+        return -1;
+    }
+    screen = DefaultScreen(display);
+    if ((g.rootw != DisplayWidth(display, screen))
+        || (g.rooth != DisplayHeight(display, screen))
+        || (g.timestamp != geometry::config_timestamp(display)))
+    {
+        return -1;
+    }
+    geometry::query_workarea(display, workarea);
+    if ((g.workarea[0] != workarea.x) || (g.workarea[1] != workarea.y)
+        || (g.workarea[2] != workarea.width)
+        || (g.workarea[3] != workarea.height))
+    {
+        return -1;
+    }
+
+    geometry::unpack(g, MONITORS);
+    WORKAREA = {(int) g.workarea[0], (int) g.workarea[1], (int) g.workarea[2],
+                (int) g.workarea[3]};
+    return 0;
+}
+
+/**
+ * @brief Read the geometry that was published in shared memory, without
+ *        checking it against the X server.
+ * 
+ * @details Used to estimate a position before connecting to the X server. The
+ *          geometry may be out of date, so the result must be checked once
+ *          connected, see load().
+ * 
+ * @param[out] monitors The list of monitors.
+ * 
+ * @return 0 on success, and -1 if nothing was published.
+ */
+int geometry::peek(monitorlist_t& monitors)
+{
+    struct SharedMemGeometry g;
+    if (AriaSharedMem::getgeometry(&g) < 0)
+    {
+        return -1;
+    }
+    geometry::unpack(g, monitors);
+    return 0;
+}
+
+/**
+ * @brief Convert the geometry in shared memory to a list of monitors.
+ * 
+ * @param[in]  g        The geometry in shared memory.
+ * @param[out] monitors The list of monitors.
+ */
+void geometry::unpack(const struct SharedMemGeometry& g,
+                      monitorlist_t& monitors)
+{
+    long i;
+    monitors.clear();
+    for (i=0; (i < g.nmonitors) && (i < SHAREDMEM_MONITORS); ++i)
+    {
+        const struct SharedMemMonitor* m = &g.monitors[i];
+        monitors.push_back({(int) m->x, (int) m->y, (int) m->w, (int) m->h,
+                            (bool) m->primary, {(int) m->wx, (int) m->wy,
+                                                (int) m->ww, (int) m->wh}});
+    }
+}
+
+/**
+ * @brief Query the X server for the geometry of each monitor, and publish it in
+ *        shared memory.
+ * 
+ * @details Use the RandR monitor list, which describes every monitor in a
+ *          single request, instead of one request for the screen resources and
+ *          another for each CRTC. If the server does not support it, the whole
+ *          screen is treated as one monitor. The RandR configuration timestamp
+ *          is published along with the geometry, so that geometry from an
+ *          older configuration never replaces that of a newer one. The usable
+ *          area of each monitor is published as well, so that the struts of
+ *          every panel and dock are only read once per change.
+ * 
+ * @param[in] display An open connection to the X server.
+ * 
+ * @return 0 on success, and -1 if there is no connection to the X server.
+ */
+int geometry::query(Display* display)
+{
+    struct SharedMemGeometry g = {};
+    XRRMonitorInfo* info;
+    Window root;
+    int screen;
+    int major;
+    int minor;
+    int num = 0;
+    int i;
+    if (!display)
+    {
+        fprintf(stderr, "%s: No connection to the X server.\n", PROGRAM);
+        return -1;
+    }
+
+    screen = DefaultScreen(display);
+    root   = RootWindow(display, screen);
+    MONITORS.clear();
+    g.timestamp = geometry::config_timestamp(display);
+    if (XRRQueryVersion(display, &major, &minor)
+        && ((major > 1) || ((major == 1) && (minor >= 5))))
+    {
+        if ((info=XRRGetMonitors(display, root, True, &num)))
+        {
+            for (i=0; i < num; ++i)
+            {
+                MONITORS.push_back({info[i].x, info[i].y, info[i].width,
+                                    info[i].height, (bool) info[i].primary,
+                                    {info[i].x, info[i].y, info[i].width,
+                                     info[i].height}});
+            }
+            XRRFreeMonitors(info);
+        }
+    }
+    if (MONITORS.empty())
+    {
+        int w = DisplayWidth(display, screen);
+        int h = DisplayHeight(display, screen);
+        MONITORS.push_back({0, 0, w, h, true, {0, 0, w, h}});
+    }
+    geometry::query_workarea(display, WORKAREA);
+    geometry::query_struts(display, MONITORS, WORKAREA);
+
+    g.rootw       = DisplayWidth(display, screen);
+    g.rooth       = DisplayHeight(display, screen);
+    g.workarea[0] = WORKAREA.x;
+    g.workarea[1] = WORKAREA.y;
+    g.workarea[2] = WORKAREA.width;
+    g.workarea[3] = WORKAREA.height;
+    for (auto& m : MONITORS)
+    {
+        if (g.nmonitors == SHAREDMEM_MONITORS)
+        {
+            break;
+        }
+        g.monitors[g.nmonitors++] = {m.x, m.y, m.width, m.height, m.primary,
+                                     m.workarea.x, m.workarea.y,
+                                     m.workarea.width, m.workarea.height};
+    }
+    AriaSharedMem::setgeometry(&g);
+    return 0;
+}
+
+/**
+ * @brief Query the X server for the RandR configuration timestamp.
+ * 
+ * @details The current screen resources are used, which, unlike the screen
+ *          info, do not make the X server poll the outputs.
+ * 
+ * @param[in] display An open connection to the X server.
+ * 
+ * @return The timestamp, or 0 if the server does not support RandR 1.3.
+ */
+long geometry::config_timestamp(Display* display)
+{
+    XRRScreenResources* resources;
+    long timestamp = 0;
+    int major;
+    int minor;
+    if (XRRQueryVersion(display, &major, &minor)
+        && ((major > 1) || ((major == 1) && (minor >= 3)))
+        && (resources=XRRGetScreenResourcesCurrent(display,
+                                                   DefaultRootWindow(display))))
+    {
+        timestamp = resources->configTimestamp;
+        XRRFreeScreenResources(resources);
+    }
+    return timestamp;
+}
+
+/**
+ * @brief Query the X server for the work area of the current desktop.
+ * 
+ * @param[in]  display  An open connection to the X server.
+ * @param[out] workarea The work area. If the window manager does not set one,
+ *                      this is the whole root window.
+ * 
+ * @return 0 if the window manager sets the work area, and -1 otherwise.
+ */
+int geometry::query_workarea(Display* display, struct area& workarea)
+{
+    std::vector<long> desktop;
+    std::vector<long> area;
+    int screen = DefaultScreen(display);
+    size_t i = 0;
+    workarea = {0, 0, DisplayWidth(display, screen),
+                DisplayHeight(display, screen)};
+
+    if (geometry::get_property(display, RootWindow(display, screen),
+                               "_NET_CURRENT_DESKTOP", desktop) == 0)
+    {
+        i = 4 * desktop[0];
+    }
+    if ((geometry::get_property(display, RootWindow(display, screen),
+                                "_NET_WORKAREA", area) < 0)
+        || (area.size() < 4))
+    {
+        return -1;
+    }
+    if (i+4 > area.size())
+    {
+        i = 0;
+    }
+    workarea = {(int) area[i], (int) area[i+1], (int) area[i+2],
+                (int) area[i+3]};
+    return 0;
+}
+
+/**
+ * @brief Determine the usable area of each monitor from the struts that panels
+ *        and docks reserve.
+ * 
+ * @details _NET_WORKAREA is a single rectangle for the whole screen, which
+ *          does not describe panels that only sit on one monitor. Instead,
+ *          read the struts of every client window, and remove the area each
+ *          one reserves from the monitors it touches. If the window manager
+ *          does not list its client windows, fall back to the part of each
+ *          monitor that is inside _NET_WORKAREA.
+ * 
+ *          A client window may be destroyed while its struts are read. The
+ *          error is trapped through GDK when it owns the connection, so that
+ *          its own error handler stays in place, and is ignored with a
+ *          temporary error handler otherwise, i.e. for the x11 backend.
+ * 
+ * @param[in]     display  An open connection to the X server.
+ * @param[in,out] monitors The list of monitors.
+ * @param[in]     workarea The work area of the current desktop.
+ * 
+ * @return 0 if the struts were read, and -1 if _NET_WORKAREA was used.
+ */
+int geometry::query_struts(Display* display, monitorlist_t& monitors,
+                           const struct area& workarea)
+{
+    std::vector<long> clients;
+    std::vector<long> strut;
+    int screen = DefaultScreen(display);
+    int rootw  = DisplayWidth(display, screen);
+    int rooth  = DisplayHeight(display, screen);
+    int (*handler)(Display*, XErrorEvent*) = NULL;
+    GdkDisplay* gdkdisplay;
+    if (geometry::get_property(display, RootWindow(display, screen),
+                               "_NET_CLIENT_LIST", clients, XA_WINDOW) < 0)
+    {
+        for (auto& m : monitors)
+        {
+            int x1 = std::max(m.x, workarea.x);
+            int y1 = std::max(m.y, workarea.y);
+            int x2 = std::min(m.x+m.width, workarea.x+workarea.width);
+            int y2 = std::min(m.y+m.height, workarea.y+workarea.height);
+            if ((x2 > x1) && (y2 > y1))
+            {
+                m.workarea = {x1, y1, x2-x1, y2-y1};
+            }
+        }
+        return -1;
+    }
+
+    if ((gdkdisplay=gdk_x11_lookup_xdisplay(display)))
+    {
+        gdk_x11_display_error_trap_push(gdkdisplay);
+    }
+    else
+    {
+        handler = XSetErrorHandler(&geometry::ignore_error);
+    }
+    for (long window : clients)
+    {
+        if ((geometry::get_property(display, window, "_NET_WM_STRUT_PARTIAL",
+                                    strut) < 0)
+            || (strut.size() < 12))
+        {
+            if ((geometry::get_property(display, window, "_NET_WM_STRUT",
+                                        strut) < 0)
+                || (strut.size() < 4))
+            {
+                continue;
+            }
+            strut.resize(4);
+            strut.insert(strut.end(), {0, rooth, 0, rooth, 0, rootw, 0,
+                                       rootw});
+        }
+        for (auto& m : monitors)
+        {
+            geometry::apply_strut(m, strut, rootw, rooth);
+        }
+    }
+    if (gdkdisplay)
+    {
+        gdk_x11_display_error_trap_pop_ignored(gdkdisplay);
+    }
+    else
+    {
+        XSync(display, False);
+        XSetErrorHandler(handler);
+    }
+    return 0;
+}
+
+/**
+ * @brief Remove the area reserved by a strut from the usable area of a
+ *        monitor.
+ * 
+ * @details A strut reserves space along an edge of the root window, over a
+ *          range of the other axis. The space only affects the monitor if the
+ *          range overlaps the monitor and the reserved space reaches into it.
+ * 
+ * @param[in,out] monitor The monitor.
+ * @param[in]     strut   The strut, in the _NET_WM_STRUT_PARTIAL format: left,
+ *                        right, top, bottom, followed by the start and end of
+ *                        the range of each of them.
+ * @param[in]     rootw   Width of the root window.
+ * @param[in]     rooth   Height of the root window.
+ */
+void geometry::apply_strut(struct monitor& monitor,
+                           const std::vector<long>& strut, int rootw, int rooth)
+{
+    struct area& a = monitor.workarea;
+    int x1 = a.x;
+    int y1 = a.y;
+    int x2 = a.x + a.width;
+    int y2 = a.y + a.height;
+    int mx2 = monitor.x + monitor.width;
+    int my2 = monitor.y + monitor.height;
+    if ((strut[0] > monitor.x) && (strut[4] < my2) && (strut[5] >= monitor.y))
+    {
+        x1 = std::max(x1, (int) strut[0]);
+    }
+    if ((rootw-strut[1] < mx2) && (strut[6] < my2) && (strut[7] >= monitor.y))
+    {
+        x2 = std::min(x2, (int) (rootw-strut[1]));
+    }
+    if ((strut[2] > monitor.y) && (strut[8] < mx2) && (strut[9] >= monitor.x))
+    {
+        y1 = std::max(y1, (int) strut[2]);
+    }
+    if ((rooth-strut[3] < my2) && (strut[10] < mx2) && (strut[11] >= monitor.x))
+    {
+        y2 = std::min(y2, (int) (rooth-strut[3]));
+    }
+    if ((x2 > x1) && (y2 > y1))
+    {
+        a = {x1, y1, x2-x1, y2-y1};
+    }
+}
+
+/**
+ * @brief Determine the stack that a notification bubble belongs to, from its
+ *        gravity.
+ * 
+ * @param[in] name The gravity: "top-left", "top-right", "bottom-left", or
+ *                 "bottom-right".
+ * 
+ * @return The gravity of the stack. An unknown gravity is treated as top-left,
+ *         where the x-y positions are used as is.
+ */
+long geometry::gravity(const std::string& name)
+{
+    if (name == "top-right")
+    {
+        return SHAREDMEM_TOP_RIGHT;
+    }
+    else if (name == "bottom-left")
+    {
+        return SHAREDMEM_BOTTOM_LEFT;
+    }
+    else if (name == "bottom-right")
+    {
+        return SHAREDMEM_BOTTOM_RIGHT;
+    }
+    return SHAREDMEM_TOP_LEFT;
+}
+
+/**
+ * @brief Place a notification bubble in the work area of a monitor, relative
+ *        to the corner given by its gravity.
+ * 
+ * @details The offsets are measured from the corner towards the center of the
+ *          work area. The result is clamped, so that the notification bubble
+ *          stays inside the work area.
+ * 
+ * @param[in]     workarea The work area of the monitor.
+ * @param[in]     gravity  The gravity of the notification bubble.
+ * @param[in,out] x        X-offset from the corner, and then the X-position on
+ *                         the screen.
+ * @param[in,out] y        Y-offset from the corner, and then the Y-position on
+ *                         the screen.
+ * @param[in]     width    Width of the notification bubble.
+ * @param[in]     height   Height of the notification bubble.
+ */
+void geometry::place(const struct area& workarea, long gravity, int& x, int& y,
+                     int width, int height)
+{
+    const struct area& a = workarea;
+    if ((gravity == SHAREDMEM_BOTTOM_LEFT) || (gravity == SHAREDMEM_BOTTOM_RIGHT))
+    {
+        y = a.height - (height + y);
+    }
+    if ((gravity == SHAREDMEM_TOP_RIGHT) || (gravity == SHAREDMEM_BOTTOM_RIGHT))
+    {
+        x = a.width - (width + x);
+    }
+    x = a.x + std::max(0, std::min(x, a.width - width));
+    y = a.y + std::max(0, std::min(y, a.height - height));
+}
+
+/**
+ * @brief Check if an event announces a change to the work area.
+ * 
+ * @details The window manager updates _NET_WORKAREA on the root window
+ *          whenever a panel or dock changes its struts.
+ * 
+ * @param[in] display An open connection to the X server.
+ * @param[in] event   The event.
+ * 
+ * @return True if the event is a change to _NET_WORKAREA, and false otherwise.
+ */
+bool geometry::is_workarea_event(Display* display, XEvent* event)
+{
+    static Atom workarea = None;
+    if (event->type != PropertyNotify)
+    {
+        return false;
+    }
+    if (workarea == None)
+    {
+        workarea = XInternAtom(display, "_NET_WORKAREA", False);
+    }
+    return (event->xproperty.atom == workarea);
+}
+
+/**
+ * @brief Ignore an X error, e.g. from a client window that was destroyed while
+ *        its struts were being read.
+ * 
+ * @param[in] display An open connection to the X server.
+ * @param[in] error   The error.
+ * 
+ * @return 0, as the return value is ignored.
+ */
+int geometry::ignore_error(Display* display, XErrorEvent* error)
+{
+    return 0;
+}
+
+/**
+ * @brief Read a property of a window that is a list of 32-bit values.
+ * 
+ * @param[in]  display An open connection to the X server.
+ * @param[in]  window  The window to read the property of.
+ * @param[in]  name    Name of the property.
+ * @param[out] values  Values of the property.
+ * @param[in]  type    Type of the property.
+ * 
+ * @return 0 on success, and -1 if the window does not have the property.
+ */
+int geometry::get_property(Display* display, Window window, const char* name,
+                           std::vector<long>& values, Atom type)
+{
+    Atom property = XInternAtom(display, name, True);
+    Atom actual;
+    int format;
+    unsigned long num;
+    unsigned long remaining;
+    unsigned char* data = NULL;
+    values.clear();
+    if ((property == None)
+        || (XGetWindowProperty(display, window, property, 0, 1024, False,
+                               type, &actual, &format, &num, &remaining,
+                               &data) != Success))
+    {
+        return -1;
+    }
+    if ((actual == type) && (format == 32))
+    {
+        values.assign((long*) data, (long*) data + num);
+    }
+    if (data)
+    {
+        XFree(data);
+    }
+    return values.empty() ? -1 : 0;
+}
+
+/**
+ * @brief Query the X server for the current geometry, after it reported that
+ *        the monitor layout changed, and publish it for other processes.
+ * 
+ * @param[in] display An open connection to the X server.
+ * 
+ * @return See query().
+ */
+int geometry::refresh(Display* display)
+{
+    int status;
+    geometry::invalidate();
+    if ((status=geometry::query(display)) == 0)
+    {
+        VALID = true;
+    }
+    return status;
+}
+
+/**
+ * @brief Discard the cached monitor geometry, so that it is retrieved again the
+ *        next time it is needed.
+ */
+void geometry::invalidate(void)
+{
+    VALID = false;
+}
+
+ARIA_NAMESPACE_END
@@ -0,0 +1,402 @@
+/**
+ * @file history.cpp
+ * @author Gabriel Gonzalez
+ * 
+ * @brief History of the notifications that were shown, kept in a ring buffer
+ *        that is shared between processes.
+ */
+
+#include "history.hpp"
+#include "config.hpp"
+#include "overflow.hpp"
+#include "sharedmem.hpp"
+#include <fcntl.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+ARIA_NAMESPACE
+
+/**
+ * @brief Identifies the layout of the history file.
+ */
+static const unsigned long kMagic = 0x4152494148000001UL;
+
+/**
+ * @brief The mapped header, followed by the entries.
+ */
+static struct history::header* HEADER = NULL;
+
+/**
+ * @brief The mapped entries.
+ */
+static struct history::entry* ENTRIES = NULL;
+
+/**
+ * @brief Copy a field into the text of an entry.
+ * 
+ * @details Once the text is full, the later fields are empty, and take no
+ *          room, not even for their null character.
+ * 
+ * @param[in,out] e     The entry.
+ * @param[in,out] used  Number of bytes of text that are used.
+ * @param[in]     field The field.
+ * 
+ * @return Length of the field that was copied, which is cut off if it does
+ *         not fit.
+ */
+static unsigned int put_text(struct history::entry* e, size_t& used,
+                             const std::string& field)
+{
+    if (used >= history::kText)
+    {
+        return 0;
+    }
+    size_t length = std::min(field.size(), history::kText - used - 1);
+    memcpy(e->text + used, field.data(), length);
+    e->text[used+length] = '\0';
+    used += length + 1;
+    return length;
+}
+
+/**
+ * @brief Number of bytes of text that a field can take, before its null
+ *        character, when it starts at an offset.
+ * 
+ * @param[in] offset Offset of the field in the text of an entry.
+ * 
+ * @return The number of bytes, which is 0 past the end of the text.
+ */
+static size_t room(size_t offset)
+{
+    return (offset < history::kText) ? (history::kText - offset - 1) : 0;
+}
+
+/**
+ * @brief Print a field of an entry, with tabs and line breaks as spaces, so
+ *        that each entry takes one line.
+ * 
+ * @param[in] text   The field.
+ * @param[in] length Length of the field.
+ * @param[in] out    Where the line is built.
+ */
+static void put_field(const char* text, size_t length, std::string& out)
+{
+    for (size_t i = 0; i < length; ++i)
+    {
+        out += ((text[i] == '\t') || (text[i] == '\n') || (text[i] == '\r'))
+            ? ' ' : text[i];
+    }
+}
+
+/**
+ * @brief Determine the earliest time of the entries to print, from --since.
+ * 
+ * @details The time is either a duration before now, as a number of seconds,
+ *          optionally followed by s, m, h, or d, or a local date and time in
+ *          the form "YYYY-MM-DD[ HH:MM[:SS]]".
+ * 
+ * @param[in] value The value of --since.
+ * 
+ * @return The time, in seconds since the epoch, 0 if there is no value, and -1
+ *         if it is invalid.
+ */
+static long parse_since(const std::string& value)
+{
+    const char* formats[] = {"%Y-%m-%d %H:%M:%S", "%Y-%m-%d %H:%M",
+                             "%Y-%m-%d"};
+    struct tm tm;
+    char* end;
+    if (value.empty())
+    {
+        return 0;
+    }
+
+    long amount = std::strtol(value.c_str(), &end, 10);
+    if ((end != value.c_str()) && (amount >= 0)
+        && ((*end == '\0') || (end[1] == '\0')))
+    {
+        switch (*end)
+        {
+        case '\0':
+        case 's':
+            return time(0) - amount;
+        case 'm':
+            return time(0) - amount*60;
+        case 'h':
+            return time(0) - amount*3600;
+        case 'd':
+            return time(0) - amount*86400;
+        default:
+            break;
+        }
+    }
+    for (const char* format : formats)
+    {
+        memset(&tm, 0, sizeof(tm));
+        end = strptime(value.c_str(), format, &tm);
+        if (end && (*end == '\0'))
+        {
+            tm.tm_isdst = -1;
+            return mktime(&tm);
+        }
+    }
+    return -1;
+}
+
+/**
+ * @brief Path to the file that holds the history.
+ * 
+ * @details The file is kept in $XDG_RUNTIME_DIR, which is private to the user
+ *          and cleared when they log out, or in /tmp, with the user ID in its
+ *          name, if that is not set.
+ * 
+ * @return The path.
+ */
+std::string history::path(void)
+{
+    const char* dir = getenv("XDG_RUNTIME_DIR");
+    if (dir && (dir[0] != '\0'))
+    {
+        return std::string(dir) + "/" + PROGRAM + "-history";
+    }
+    return std::string("/tmp/") + PROGRAM + "-history-"
+        + std::to_string(getuid());
+}
+
+/**
+ * @brief Open and map the history file.
+ * 
+ * @details The file is created, and grown to its full size, by whichever
+ *          process opens it first, and is only readable by the user. A file
+ *          that belongs to another user, e.g. one made in /tmp ahead of time,
+ *          is not used. A file with a different layout is cleared. The mapping
+ *          is kept for the rest of the process.
+ * 
+ * @return 0 on success, and -1 if the file can not be opened or mapped.
+ */
+int history::open(void)
+{
+    size_t size = sizeof(struct history::entry)
+        * (history::kLength + 1);
+    struct stat statbuf;
+    void* addr;
+    int fd;
+    if (HEADER)
+    {
+        return 0;
+    }
+    if ((fd=::open(history::path().c_str(),
+                   O_RDWR | O_CREAT | O_NOFOLLOW | O_CLOEXEC, 0600)) < 0)
+    {
+        return -1;
+    }
+    if ((fstat(fd, &statbuf) < 0) || (statbuf.st_uid != getuid())
+        || (((size_t) statbuf.st_size < size) && (ftruncate(fd, size) < 0)))
+    {
+        ::close(fd);
+        return -1;
+    }
+
+    addr = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (addr == MAP_FAILED)
+    {
+        ::close(fd);
+        return -1;
+    }
+    HEADER  = (struct history::header*) addr;
+    ENTRIES = (struct history::entry*) addr + 1;
+    if (__atomic_load_n(&HEADER->magic, __ATOMIC_ACQUIRE) != kMagic)
+    {
+        flock(fd, LOCK_EX);
+        if (HEADER->magic != kMagic)
+        {
+            memset(addr, 0, size);
+            __atomic_store_n(&HEADER->magic, kMagic, __ATOMIC_RELEASE);
+        }
+        flock(fd, LOCK_UN);
+    }
+    ::close(fd);
+    return 0;
+}
+
+/**
+ * @brief Append a notification to the history.
+ * 
+ * @details The entry is claimed by taking the next sequence number, and its
+ *          sequence is odd while it is filled in, so that a reader skips it
+ *          until it is complete. Nothing is appended when history is set to
+ *          false in the config file.
+ * 
+ * @param[in] cli The command line interface.
+ * 
+ * @return 0 on success, and -1 if the history is disabled or can not be
+ *         opened.
+ */
+int history::append(commandline::interface& cli)
+{
+    size_t used = 0;
+    if ((config::read("history") == "false") || (history::open() < 0))
+    {
+        return -1;
+    }
+
+    unsigned long n = __atomic_fetch_add(&HEADER->head, 1, __ATOMIC_ACQ_REL);
+    struct history::entry* e = &ENTRIES[n % history::kLength];
+    __atomic_store_n(&e->sequence, 2*n+1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    e->time     = time(0);
+    e->urgency  = std::max(overflow::urgency(cli),
+                           (long) SHAREDMEM_URGENCY_LOW);
+    e->titlelen = put_text(e, used, cli.get("title"));
+    e->bodylen  = put_text(e, used, cli.get("body"));
+    e->taglen   = put_text(e, used, cli.get("tag"));
+    __atomic_store_n(&e->sequence, 2*n+2, __ATOMIC_RELEASE);
+    return 0;
+}
+
+/**
+ * @brief Print the notifications in the history that match --grep and
+ *        --since.
+ * 
+ * @details Entries are printed oldest first, one per line, with the time,
+ *          urgency, tag, title, and body separated by tabs. Each entry is
+ *          searched where it is mapped, and only printed if its sequence did
+ *          not change in the meantime, i.e. it was not overwritten.
+ * 
+ * @param[in] cli The command line interface.
+ * 
+ * @return 0 on success, and 14 if the history can not be opened or --since is
+ *         invalid.
+ */
+int history::print(commandline::interface& cli)
+{
+    const char* levels[] = {"low", "normal", "critical"};
+    std::string pattern = cli.get("grep");
+    std::string line;
+    long since = parse_since(cli.get("since"));
+    char stamp[32];
+    struct tm tm;
+    if (since < 0)
+    {
+        fprintf(stderr, "%s: Invalid time '%s'.\n", PROGRAM,
+                cli.get("since").c_str());
+        return 14;
+    }
+    if (history::open() < 0)
+    {
+        fprintf(stderr, "%s: Unable to open history '%s'.\n", PROGRAM,
+                history::path().c_str());
+        return 14;
+    }
+
+    unsigned long head = __atomic_load_n(&HEADER->head, __ATOMIC_ACQUIRE);
+    unsigned long n = (head > history::kLength) ? (head - history::kLength) : 0;
+    for (; n < head; ++n)
+    {
+        struct history::entry* e = &ENTRIES[n % history::kLength];
+        unsigned long seq = __atomic_load_n(&e->sequence, __ATOMIC_ACQUIRE);
+        size_t title = std::min((size_t) e->titlelen, history::kText-1);
+        size_t body  = std::min((size_t) e->bodylen, room(title+1));
+        size_t tag   = std::min((size_t) e->taglen, room(title+body+2));
+        size_t used  = std::min(title+body+tag+2, history::kText);
+        long urgency = std::min(std::max(e->urgency, 0L), 2L);
+        time_t t     = e->time;
+        if ((seq != 2*n+2) || (t < since)
+            || (!pattern.empty()
+                && !history::contains(e->text, used, pattern)))
+        {
+            continue;
+        }
+
+        localtime_r(&t, &tm);
+        strftime(stamp, sizeof(stamp), "%Y-%m-%d %H:%M:%S", &tm);
+        line  = stamp;
+        line += '\t';
+        line += levels[urgency];
+        line += '\t';
+        put_field(e->text+title+body+2, tag, line);
+        line += '\t';
+        put_field(e->text, title, line);
+        line += '\t';
+        put_field(e->text+title+1, body, line);
+        line += '\n';
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        if (__atomic_load_n(&e->sequence, __ATOMIC_RELAXED) == seq)
+        {
+            fwrite(line.data(), 1, line.size(), stdout);
+        }
+    }
+    return 0;
+}
+
+/**
+ * @brief Check whether text contains a pattern.
+ * 
+ * @details With SSE2, 16 positions are checked at a time, by comparing the
+ *          first and last character of the pattern against the text, and
+ *          only positions where both match are compared in full. This skips
+ *          most of the text in a few instructions, so that the whole ring can
+ *          be searched in a few milliseconds.
+ * 
+ * @param[in] text    The text.
+ * @param[in] length  Length of the text.
+ * @param[in] pattern The pattern.
+ * 
+ * @return True if the text contains the pattern, and false otherwise.
+ */
+bool history::contains(const char* text, size_t length,
+                       const std::string& pattern)
+{
+    const char* p = pattern.data();
+    size_t m = pattern.size();
+    size_t i = 0;
+    if (m == 0)
+    {
+        return true;
+    }
+    if (m > length)
+    {
+        return false;
+    }
+
+#if defined(__SSE2__)
+    const __m128i first = _mm_set1_epi8(p[0]);
+    const __m128i last  = _mm_set1_epi8(p[m-1]);
+    for (; i + m + 15 <= length; i += 16)
+    {
+        __m128i a = _mm_loadu_si128((const __m128i*) (text + i));
+        __m128i b = _mm_loadu_si128((const __m128i*) (text + i + m - 1));
+        unsigned int mask = _mm_movemask_epi8(
+            _mm_and_si128(_mm_cmpeq_epi8(a, first), _mm_cmpeq_epi8(b, last)));
+        while (mask != 0)
+        {
+            if (memcmp(text + i + __builtin_ctz(mask), p, m) == 0)
+            {
+                return true;
+            }
+            mask &= mask - 1;
+        }
+    }
+#endif
+    for (; i + m <= length; ++i)
+    {
+        if ((text[i] == p[0]) && (memcmp(text + i, p, m) == 0))
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+ARIA_NAMESPACE_END
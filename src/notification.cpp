@@ -8,20 +8,30 @@
  */
 
 #include "notification.hpp"
+#include "coalesce.hpp"
+#include "render.hpp"
 #include "sharedmem.hpp"
+#include "sizecache.hpp"
+#include "startup.hpp"
+#include "summary.hpp"
+#include "tag.hpp"
 #include "commandline.hpp"
 #include "config.hpp"
+#include "geometry.hpp"
+#include "overflow.hpp"
+#include "progress.hpp"
 #include "util.hpp"
 #include <gtkmm.h>
 #include <gdkmm.h>
+#include <gdk/gdkx.h>
+#include <glib-unix.h>
 #include <time.h>
 #include <unistd.h>
-#include <pangomm/fontdescription.h>
-#include <sys/stat.h>
-#include <X11/Xlib.h>
-#include <X11/extensions/Xrandr.h>
+#include <algorithm>
+#include <cmath>
 #include <cstdlib>
 #include <csignal>
+#include <cstring>
 #include <iostream>
 #include <sstream>
 #include <string>
@@ -37,21 +47,111 @@ notification::notification() :
     bubble_(Gtk::ORIENTATION_HORIZONTAL),
     icon_(Gtk::ORIENTATION_VERTICAL),
     text_(Gtk::ORIENTATION_VERTICAL),
+    bar_(),
     background_(),
+    foreground_(),
     width_(0),
     height_(0),
     xpos_(0),
     ypos_(0),
-    curve_(0)
+    curve_(0),
+    plain_(false),
+    maxlines_(0),
+    maxwidth_(0),
+    sizekey_(0),
+    contentkey_(0),
+    count_(1),
+    time_(0),
+    timeout_(),
+    tagkey_(0),
+    urgency_(SHAREDMEM_URGENCY_NORMAL),
+    seen_(0),
+    title_(NULL),
+    body_(NULL),
+    image_(NULL),
+    font_(),
+    titlesize_(),
+    bodysize_(),
+    autowidth_(false),
+    autoheight_(false),
+    progress_(),
+    fraction_(0),
+    progresstick_(0),
+    stylesheet_(),
+    provider_(),
+    index_(0),
+    id_(0),
+    reflowsource_(0),
+    repeatsource_(0),
+    xcur_(0),
+    ycur_(0),
+    fadeintime_(0),
+    fadeouttime_(0),
+    slidetime_(0),
+    fade_(),
+    slidex_(),
+    slidey_(),
+    tick_(0),
+    dismissed_(false),
+    placed_(false),
+    framestats_(false),
+    lastframe_(0),
+    frames_(0),
+    dropped_(0),
+    drawtime_(0),
+    drawmax_(0)
 {
+    static int count = 0;
+    this->set_name("aria" + std::to_string(count++));
     this->set_decorated(false);
     this->set_app_paintable(true);
+    this->get_style_context()->add_class("aria");
+    this->bubble_.get_style_context()->add_class("bubble");
+    this->icon_.get_style_context()->add_class("icon");
+    this->text_.get_style_context()->add_class("text");
+    this->bar_.get_style_context()->add_class("bar");
+    this->bar_.signal_draw().connect(sigc::mem_fun(*this, &notification::on_bar_draw));
+    this->progress_.fd = -1;
     this->signal_draw().connect(sigc::mem_fun(*this, &notification::on_draw));
     this->signal_screen_changed().connect(sigc::mem_fun(*this, &notification::on_screen_changed));
     this->on_screen_changed(get_screen());
-    std::signal(SIGINT,  cleanup);
-    std::signal(SIGQUIT, cleanup);
-    std::signal(SIGTERM, cleanup);
+    this->get_screen()->signal_monitors_changed().connect(sigc::mem_fun(*this, &notification::on_monitors_changed));
+    GdkWindow* root = gdk_screen_get_root_window(this->get_screen()->gobj());
+    gdk_window_set_events(root, (GdkEventMask) (gdk_window_get_events(root)
+                                                | GDK_PROPERTY_CHANGE_MASK));
+    gdk_window_add_filter(root, &notification::on_root_event, this);
+    std::signal(SIGQUIT, &notification::on_quit);
+    this->interruptsource_ = g_unix_signal_add(SIGINT,
+                                               &notification::on_terminate,
+                                               this);
+    this->terminatesource_ = g_unix_signal_add(SIGTERM,
+                                               &notification::on_terminate,
+                                               this);
+    this->reflowsource_ = g_unix_signal_add(SIGUSR1, &notification::on_reflow,
+                                            this);
+    this->repeatsource_ = g_unix_signal_add(SIGUSR2, &notification::on_repeat,
+                                            this);
+}
+
+/**
+ * @brief Stop handling signals and events for the notification bubble.
+ * 
+ * @details The signal sources and the filter on the root window are given the
+ *          notification bubble itself, so they are removed before it is gone.
+ */
+notification::~notification()
+{
+    GdkWindow* root = gdk_screen_get_root_window(this->get_screen()->gobj());
+    gdk_window_remove_filter(root, &notification::on_root_event, this);
+    g_source_remove(this->reflowsource_);
+    g_source_remove(this->repeatsource_);
+    g_source_remove(this->interruptsource_);
+    g_source_remove(this->terminatesource_);
+    if (this->provider_)
+    {
+        Gtk::StyleContext::remove_provider_for_screen(this->get_screen(),
+                                                      this->provider_);
+    }
 }
 
 /**
@@ -64,7 +164,8 @@ notification::notification() :
  * @param[in] cli The command line interface, containing all the command line
  *                information.
  * 
- * @return 0 on success. Any other value is an error.
+ * @return 0 on success. Any other value is an error, and 13 if the source of
+ *         the progress bar could not be opened.
  */
 int notification::build(commandline::interface& cli)
 {
@@ -73,12 +174,15 @@ int notification::build(commandline::interface& cli)
     std::string font         = cli.get("font");
     std::string titlesize    = cli.get("title-size");
     std::string bodysize     = cli.get("body-size");
+    std::string maxlines     = cli.get("max-lines");
+    std::string maxwidth     = cli.get("max-width");
     std::string icon         = cli.get("icon");
     std::string spacing      = cli.get("icon-text-spacing");
     std::string time         = cli.get("time");
     std::string xpos         = cli.get("xpos");
     std::string ypos         = cli.get("ypos");
     std::string gravity      = cli.get("gravity");
+    std::string monitor      = cli.get("monitor");
     std::string width        = cli.get("width");
     std::string height       = cli.get("height");
     std::string background   = cli.get("background");
@@ -90,12 +194,42 @@ int notification::build(commandline::interface& cli)
     std::string marginbottom = cli.get("margin-bottom");
     std::string marginleft   = cli.get("margin-left");
     std::string marginright  = cli.get("margin-right");
+    std::string fadein       = cli.get("fade-in");
+    std::string fadeout      = cli.get("fade-out");
+    std::string slide        = cli.get("slide");
+    std::string source       = cli.get("progress");
+    struct SharedMemPayload folded = {};
+    int status;
+
+    this->id_         = AriaSharedMem::self();
+    this->plain_      = cli.has("plain");
+    this->framestats_ = cli.has("frame-stats");
+    if (summary::collect(folded))
+    {
+        title = folded.title;
+        body  = folded.body;
+    }
 
-    if (this->set_notify_title_and_body(title, body, font, titlesize,
-                                        bodysize) < 0)
+    if (cli.has("progress") && (this->set_notify_progress(source) < 0))
+    {
+        fprintf(stderr, "%s: Unable to open progress source '%s'.\n",
+                PROGRAM, source.c_str());
+        return 13;
+    }
+    if (this->set_notify_text_limit(maxlines, maxwidth) < 0)
+    {
+        return 1;
+    }
+    if (((status=this->set_notify_title_and_body(title, body, font, titlesize,
+                                                 bodysize)) < 0)
+        && ((status != -4) || !cli.has("progress")))
     {
         return 1;
     }
+    if (icon.empty())
+    {
+        this->set_from_config("icon", icon);
+    }
     if (this->set_notify_icon(icon, spacing) < 0)
     {
         return 2;
@@ -112,6 +246,10 @@ int notification::build(commandline::interface& cli)
     {
         return 4;
     }
+    if (this->set_notify_monitor(monitor) < 0)
+    {
+        return 4;
+    }
     if (this->set_notify_color(background, foreground, opacity) < 0)
     {
         return 5;
@@ -125,7 +263,22 @@ int notification::build(commandline::interface& cli)
     {
         return 7;
     }
+    if (this->set_notify_animation(fadein, fadeout, slide) < 0)
+    {
+        return 8;
+    }
 
+    std::string key = title + '\x1f' + body + '\x1f' + font + '\x1f'
+        + titlesize + '\x1f' + bodysize + '\x1f' + maxlines + '\x1f'
+        + maxwidth + '\x1f' + (this->plain_ ? "1" : "0") + '\x1f' + icon
+        + '\x1f' + spacing + '\x1f' + margin + '\x1f' + margintop + '\x1f'
+        + marginbottom + '\x1f' + marginleft + '\x1f' + marginright + '\x1f'
+        + curve;
+    this->sizekey_    = util::hash(key);
+    this->contentkey_ = folded.fields ? 0 : coalesce::key(cli);
+    this->tagkey_     = folded.fields ? 0 : tag::key(cli);
+    this->urgency_    = std::max(overflow::urgency(cli),
+                                 (long) SHAREDMEM_URGENCY_LOW);
     return 0;
 }
 
@@ -147,6 +300,7 @@ int notification::build(commandline::interface& cli)
  */
 int notification::show(void)
 {
+    double start = util::now();
     this->icon_.set_halign(Gtk::ALIGN_CENTER);
     this->icon_.set_valign(Gtk::ALIGN_CENTER);
     this->text_.set_halign(Gtk::ALIGN_CENTER);
@@ -156,76 +310,196 @@ int notification::show(void)
     this->bubble_.pack_start(this->icon_);
     this->bubble_.pack_start(this->text_);
     this->add(this->bubble_);
+    this->apply_style();
     this->show_all_children();
     this->resize();
+    util::profile("style", start);
     this->reposition();
+    if (this->fadeintime_ > 0)
+    {
+        Gtk::Widget::set_opacity(0.0);
+        this->fade_to(1.0, this->fadeintime_);
+    }
     return 0;
 }
 
+/**
+ * @brief Install the stylesheet that was generated while building the
+ *        notification bubble.
+ * 
+ * @details The rules are collected into a single stylesheet, as each attribute
+ *          is resolved, and loaded into one CSS provider. The provider is
+ *          created once per notification bubble and added to the screen before
+ *          any of the widgets are shown, so that each widget resolves its style
+ *          a single time, instead of being invalidated by every per-widget
+ *          override.
+ */
+void notification::apply_style(void)
+{
+    if (!this->provider_)
+    {
+        this->provider_ = Gtk::CssProvider::create();
+        Gtk::StyleContext::add_provider_for_screen(this->get_screen(),
+            this->provider_, GTK_STYLE_PROVIDER_PRIORITY_APPLICATION);
+    }
+    try
+    {
+        this->provider_->load_from_data(this->stylesheet_);
+    }
+    catch (const Glib::Error& err)
+    {
+        fprintf(stderr, "%s: Unable to load stylesheet: %s\n", PROGRAM,
+                err.what().c_str());
+    }
+}
+
 /**
  * @brief Resize the notification bubble to the desired size, if specified, or
  *        the preferred size, otherwise.
  * 
- * @details If the width and/or height are unset, determine the preferred width
- *          or height size of the widget. The curvature value is then added to
- *          the width and/or height as an additional padding.
+ * @details If the width and/or height are unset, use the size that was
+ *          measured the last time a notification bubble with the same
+ *          attributes was shown, so that the text does not have to be laid out
+ *          to size the window. The size is verified once the window is mapped,
+ *          in verify_size(). If the size has not been measured before, measure
+ *          it now and store it in the size cache.
  * 
  *          If the width and/or height are provided on the command line, use
  *          those values without modifying them.
  */
 void notification::resize(void)
+{
+    bool autowidth  = !this->width_;
+    bool autoheight = !this->height_;
+    int width;
+    int height;
+    this->autowidth_  = autowidth;
+    this->autoheight_ = autoheight;
+    if (autowidth || autoheight)
+    {
+        if (sizecache::lookup(this->sizekey_, width, height) == 0)
+        {
+            this->signal_map().connect(sigc::bind(
+                sigc::mem_fun(*this, &notification::verify_size), autowidth,
+                autoheight));
+        }
+        else
+        {
+            this->measure(width, height);
+            sizecache::store(this->sizekey_, width, height);
+        }
+        if (autowidth)
+        {
+            this->width_ = width;
+        }
+        if (autoheight)
+        {
+            this->height_ = height;
+        }
+    }
+    this->set_size_request(this->width_, this->height_);
+}
+
+/**
+ * @brief Measure the preferred size of the notification bubble.
+ * 
+ * @details The curvature value is added to the width and height as an
+ *          additional padding.
+ * 
+ * @param[out] width  The preferred width.
+ * @param[out] height The preferred height.
+ */
+void notification::measure(int& width, int& height)
 {
     int junk;
-    if (!this->width_)
+    this->bubble_.get_preferred_width(junk, width);
+    this->bubble_.get_preferred_height(junk, height);
+    width  += this->curve_;
+    height += this->curve_;
+}
+
+/**
+ * @brief Verify a size that was taken from the size cache against the actual
+ *        layout.
+ * 
+ * @details If the measured size differs, e.g. because the icon file was
+ *          changed, update the size cache, resize the notification bubble, and
+ *          place it again with its new size. Its entry in shared memory is
+ *          updated in place, see reposition(), so that it keeps its place in
+ *          the stack.
+ * 
+ * @param[in] autowidth  Whether the width was taken from the size cache.
+ * @param[in] autoheight Whether the height was taken from the size cache.
+ */
+void notification::verify_size(bool autowidth, bool autoheight)
+{
+    int width;
+    int height;
+    this->measure(width, height);
+    if ((!autowidth || (width == this->width_))
+        && (!autoheight || (height == this->height_)))
     {
-        this->bubble_.get_preferred_width(junk, this->width_);
-        this->width_ += this->curve_;
+        return;
     }
-    if (!this->height_)
+
+    sizecache::store(this->sizekey_, width, height);
+    if (autowidth)
     {
-        this->bubble_.get_preferred_height(junk, this->height_);
-        this->height_ += this->curve_;
+        this->width_ = width;
+    }
+    if (autoheight)
+    {
+        this->height_ = height;
     }
-    printf("Request: (%d, %d)\n", this->width_, this->height_);
     this->set_size_request(this->width_, this->height_);
+    this->reposition();
 }
 
 /**
  * @brief Move the notification bubble to the desired position.
  * 
- * @details Add attributes into shared memory, determine the appropriate x-y
- *          positional values, and move the notification bubble.
+ * @details Determine the appropriate x-y positional values, relative to the
+ *          corner of the usable area of the selected monitor given by the
+ *          gravity, so that panels and docks are not covered. Add attributes
+ *          into shared memory, which separates the notification bubble from
+ *          the others in the same stack on that monitor, and move the
+ *          notification bubble, sliding it if it is already on screen. The x-y
+ *          positions that were set are kept, so that the notification bubble
+ *          can be placed again if its size or the work area changes. Its
+ *          entry is updated in place, unless it moved to another monitor, in
+ *          which case it leaves the stack of the old one.
  */
 void notification::reposition(void)
 {
-    std::string g = this->gravity_;
+    long g = this->get_gravity();
     int w = this->width_;
     int h = this->height_;
     int x = this->xpos_;
     int y = this->ypos_;
-    int xpixels;
-    int ypixels;
-    if (!this->get_screen_resolution(xpixels, ypixels))
+    int index = 0;
+    struct geometry::monitor m;
+    this->select_entry();
+    if (!this->get_monitor(index, m))
     {
-        if ((g == "bottom-left") || (g == "bottom-right"))
-        {
-            y = ypixels - (h + y);
-        }
-        if ((g == "top-right") || (g == "bottom-right"))
-        {
-            x = xpixels - (w + x);
-        }
-        printf("Size: (%d, %d)\n", w, h);
-        printf("Gravity: %s\n", g.c_str());
+        geometry::place(m.workarea, g, x, y, w, h);
+    }
+    if (this->placed_ && (index != this->index_))
+    {
+        AriaSharedMem::remove(SHAREDMEM_SPACING);
     }
-    printf("Position: (%d, %d)\n", x, y);
-    this->xpos_ = x;
-    this->ypos_ = y;
-    struct SharedMemType data = {.id=getpid(), .time=time(0), .x=this->xpos_,
-                                 .y=this->ypos_, .w=this->width_,
-                                 .h=this->height_};
-    AriaSharedMem::add(&data, 10);
-    this->move(this->xpos_, this->ypos_);
+    struct SharedMemType data = {.id=this->id_, .time=time(0), .x=x, .y=y,
+                                 .w=this->width_, .h=this->height_,
+                                 .monitor=index, .gravity=g, .home=0,
+                                 .hash=this->contentkey_, .count=this->count_,
+                                 .tag=this->tagkey_, .urgency=this->urgency_};
+    this->placed_ = (AriaSharedMem::commit(&data, SHAREDMEM_SPACING) == 0);
+    this->index_ = index;
+    if (data.count > this->count_)
+    {
+        this->count_ = data.count;
+        this->queue_draw();
+    }
+    this->slide_to(data.x, data.y);
 }
 
 /**
@@ -265,6 +539,9 @@ int notification::set_notify_title_and_body(std::string& title,
     {
         return -3;
     }
+    this->font_      = font;
+    this->titlesize_ = titlesize;
+    this->bodysize_  = bodysize;
     tstatus = this->set_title(title, font, titlesize);
     bstatus = this->set_body(body, font, bodysize);
     if ((tstatus < 0) && (bstatus < 0))
@@ -274,6 +551,36 @@ int notification::set_notify_title_and_body(std::string& title,
     return 0;
 }
 
+/**
+ * @brief Set the maximum number of lines and line width of the title and body
+ *        text.
+ * 
+ * @details If either value is not specified, read it from the config file. A
+ *          value of 0 means there is no limit.
+ * 
+ * @param[in] lines Maximum number of lines, before the text is ellipsized.
+ * @param[in] width Maximum width of a line, in characters.
+ * 
+ * @return 0 on success. Any other value indicates an error.
+ */
+int notification::set_notify_text_limit(std::string& lines, std::string& width)
+{
+    if (lines.empty() && (this->set_from_config("max-lines", lines) < 0))
+    {
+        lines = "0";
+    }
+    if (width.empty() && (this->set_from_config("max-width", width) < 0))
+    {
+        width = "0";
+    }
+    if (((this->maxlines_=std::stoi(lines)) < 0)
+        || ((this->maxwidth_=std::stoi(width)) < 0))
+    {
+        return -1;
+    }
+    return 0;
+}
+
 /**
  * @brief Set the title of the notification bubble.
  * 
@@ -281,11 +588,11 @@ int notification::set_notify_title_and_body(std::string& title,
  * @param[in] font  The font to use for the title.
  * @param[in] size  The font size for the title.
  * 
- * @return See set_text(string, string, string).
+ * @return See set_text(string, string, string, string).
  */
 int notification::set_title(std::string& title, std::string& font, std::string& size)
 {
-    return this->set_text(title, font, size);
+    return this->set_text(title, font, size, "title");
 }
 
 /**
@@ -295,19 +602,31 @@ int notification::set_title(std::string& title, std::string& font, std::string&
  * @param[in] font  The font to use for the title.
  * @param[in] size  The font size for the title.
  * 
- * @return See set_text(string, string, string).
+ * @return See set_text(string, string, string, string).
  */
 int notification::set_body(std::string& body, std::string& font, std::string& size)
 {
-    return this->set_text(body, font, size);
+    return this->set_text(body, font, size, "body");
 }
 
 /**
  * @brief Generically create a label and add it to the notification bubble.
  * 
- * @details Create a label and configure it. Create a font description
- *          object. Find and replace any escaped backslashes. Add the label to
- *          the notification bubble text container.
+ * @details Create a label and configure it. Normalize the text, decoding any
+ *          escape sequences. Add a stylesheet rule for the font and size of the
+ *          label's style class. Add the label to the notification bubble text
+ *          container.
+ * 
+ *          Text is only sent through the Pango markup parser when it contains
+ *          valid markup, and plain text was not requested. Otherwise, it is set
+ *          as is, so that a '<' or '&' in the text is displayed literally.
+ * 
+ *          The label is limited to the maximum number of lines and line width,
+ *          and ellipsized past that. Plain text is also cut down before it is
+ *          given to Pango, so that the cost of laying it out does not depend
+ *          on how long the input is. With a progress bar, the body is a single
+ *          line that fills the width of the text container, so that updating
+ *          it never resizes the notification bubble.
  * 
  *          In the event that the text, font or size strings are empty, return
  *          indicating an error.
@@ -315,10 +634,12 @@ int notification::set_body(std::string& body, std::string& font, std::string& si
  * @param[in] text Text for the label.
  * @param[in] font Font for the text.
  * @param[in] size Font size for the text.
+ * @param[in] name Style class of the label, "title" or "body".
  * 
  * @return 0 on success. Any other value indicates an error.
  */
-int notification::set_text(std::string text, std::string font, std::string size)
+int notification::set_text(std::string text, std::string font, std::string size,
+                           const std::string name)
 {
     if (text.empty())
     {
@@ -334,21 +655,78 @@ int notification::set_text(std::string text, std::string font, std::string size)
     }
 
     Gtk::Label* label = Gtk::manage(new Gtk::Label());
-    Pango::FontDescription fd;
-    fd.set_family(font);
-    fd.set_size(std::stoi(size) * PANGO_SCALE);
+    std::ostringstream rule;
+    rule << "font-family: \"" << font << "\"; font-size: " << std::stoi(size)
+         << "pt;";
+    this->add_rule(name, rule.str());
 
-    util::replace_all(text, "\\", "\n");
-    label->set_use_markup(true);
-    label->set_markup(text);
+    double start = util::now();
+    this->set_label_text(label, text);
+    util::profile(name.c_str(), start);
     label->set_line_wrap();
-    label->override_font(fd);
+    if (this->maxwidth_ > 0)
+    {
+        label->set_max_width_chars(this->maxwidth_);
+    }
+    if (this->maxlines_ > 0)
+    {
+        label->set_lines(this->maxlines_);
+        label->set_ellipsize(Pango::ELLIPSIZE_END);
+    }
+    label->get_style_context()->add_class(name);
     label->set_halign(Gtk::ALIGN_START);
+    if ((name == "body") && (this->progress_.fd >= 0))
+    {
+        label->set_line_wrap(false);
+        label->set_max_width_chars(1);
+        label->set_ellipsize(Pango::ELLIPSIZE_END);
+        label->set_halign(Gtk::ALIGN_FILL);
+        label->set_xalign(0);
+    }
     this->text_.pack_start(*label, Gtk::PACK_SHRINK);
+    if (name == "title")
+    {
+        this->title_ = label;
+        this->text_.reorder_child(*label, 0);
+    }
+    else
+    {
+        this->body_ = label;
+    }
 
     return 0;
 }
 
+/**
+ * @brief Set the text of a label.
+ * 
+ * @details Normalize the text, and set it as markup or as plain text, see
+ *          set_text(string, string, string, string). Markup is parsed once,
+ *          into the stripped text and its attributes, which are set on the
+ *          label directly, instead of having the label parse it again. The
+ *          text is then truncated, whether it was markup or not.
+ * 
+ * @param[in] label The label.
+ * @param[in] text  The text.
+ */
+void notification::set_label_text(Gtk::Label* label, std::string text)
+{
+    PangoAttrList* attrs = NULL;
+    text = util::normalize(text);
+    if (!this->plain_)
+    {
+        util::parse_markup(text, &attrs);
+    }
+    util::truncate(text, this->maxlines_, this->maxwidth_);
+    label->set_use_markup(false);
+    label->set_text(text);
+    gtk_label_set_attributes(label->gobj(), attrs);
+    if (attrs)
+    {
+        pango_attr_list_unref(attrs);
+    }
+}
+
 /**
  * @brief Set the title size.
  * 
@@ -419,13 +797,12 @@ int notification::set_font_size(const std::string key, std::string& size)
  */
 int notification::set_notify_icon(std::string& path, std::string& spacing)
 {
-    struct stat statbuf;
     int s;
     if (path.empty())
     {
         return 0;
     }
-    if (stat(path.c_str(), &statbuf) != 0)
+    if (!render::check_icon(path))
     {
         return -1;
     }
@@ -439,9 +816,13 @@ int notification::set_notify_icon(std::string& path, std::string& spacing)
         return -2;
     }
 
-    Gtk::Image* icon = Gtk::manage(new Gtk::Image(path));
+    GdkPixbuf* pixbuf = startup::take_icon(path);
+    Gtk::Image* icon = pixbuf
+        ? Gtk::manage(new Gtk::Image(Glib::wrap(pixbuf)))
+        : Gtk::manage(new Gtk::Image(path));
     this->icon_.pack_start(*icon, Gtk::PACK_SHRINK);
-    this->bubble_.set_spacing(s);
+    this->image_ = icon;
+    this->add_rule("icon", "margin-right: " + std::to_string(s) + "px;");
 
     return 0;
 }
@@ -469,11 +850,28 @@ int notification::set_notify_time(std::string& time)
     {
         return -2;
     }
-    Glib::signal_timeout().connect_seconds_once(
-        sigc::bind<int>(sigc::ptr_fun(&notification::cleanup), 0), t);
+    this->time_ = t;
+    this->restart_timeout();
     return 0;
 }
 
+/**
+ * @brief Start the timeout that dismisses the notification bubble over.
+ * 
+ * @details While the progress bar is still being read, there is no timeout,
+ *          and it only starts once the source reaches its end.
+ */
+void notification::restart_timeout(void)
+{
+    this->timeout_.disconnect();
+    if ((this->progress_.fd >= 0) && !this->progress_.eof)
+    {
+        return;
+    }
+    this->timeout_ = Glib::signal_timeout().connect_seconds_once(
+        sigc::mem_fun(*this, &notification::dismiss), this->time_);
+}
+
 /**
  * @brief Set the notification bubble size (width x height).
  * 
@@ -539,6 +937,29 @@ int notification::set_notify_position(std::string& xpos, std::string& ypos,
     return 0;
 }
 
+/**
+ * @brief Set the monitor to display the notification bubble on.
+ * 
+ * @details If no monitor is entered, read it from the config file, and if it
+ *          is not there either, use the primary monitor. Each monitor has its
+ *          own stack of notification bubbles for each gravity.
+ * 
+ * @param[in] monitor The index of the monitor, "primary", "pointer" for the
+ *                    monitor with the mouse pointer, or "focused" for the
+ *                    monitor with the focused window.
+ * 
+ * @return 0 on success.
+ */
+int notification::set_notify_monitor(std::string& monitor)
+{
+    if (monitor.empty() && (this->set_from_config("monitor", monitor) < 0))
+    {
+        monitor = "primary";
+    }
+    this->monitor_ = monitor;
+    return 0;
+}
+
 /**
  * @brief Set the notification background, foreground, and opacity.
  * 
@@ -596,7 +1017,9 @@ int notification::set_foreground(std::string& color)
  * 
  * @details If color is empty and can't be read from the config file, this is an
  *          error. If key is not "background" or "foreground" this is an
- *          error. Otherwise, set the respective colors.
+ *          error. Otherwise, set the respective colors. The background is
+ *          painted in on_draw(), so only the foreground is added to the
+ *          stylesheet.
  * 
  * @param[in] key   The key to look for in the config file, in the event that
  *                  color is not specified.
@@ -606,22 +1029,21 @@ int notification::set_foreground(std::string& color)
  */
 int notification::set_color(const std::string key, std::string& color)
 {
-    auto flag = Gtk::STATE_FLAG_NORMAL;
     if (color.empty() && (this->set_from_config(key, color) < 0))
     {
         return -1;
     }
-    color = this->fix_color(color);
+    color = util::fix_color(color);
 
     if (key == "background")
     {
         this->background_.set(color);
-        this->override_background_color(this->background_, flag);
     }
     else if (key == "foreground")
     {
         Gdk::RGBA rgba(color);
-        this->override_color(rgba, flag);
+        this->foreground_ = rgba;
+        this->add_rule("aria", "color: " + rgba.to_string().raw() + ";");
     }
     else
     {
@@ -636,7 +1058,8 @@ int notification::set_color(const std::string key, std::string& color)
  * @details If opacity is not specified and this is unable to read the value
  *          from the config file, this is an error. When converting the string
  *          to a double, if the resultant value is not between 0 and 1, this is
- *          an error. Otherwise, set the opacity.
+ *          an error, as checked by render::parse_opacity(). Otherwise, set the
+ *          opacity.
  * 
  * @param[in] opacity The opacity of the notification bubble.
  * 
@@ -648,9 +1071,8 @@ int notification::set_opacity(std::string& opacity)
     {
         return -1;
     }
-    double o = std::stod(opacity);
-    int i = (int)o;
-    if ((i != 0) && (i != 1))
+    double o;
+    if (!render::parse_opacity(opacity, o))
     {
         return -2;
     }
@@ -743,11 +1165,75 @@ int notification::set_notify_margin(std::string& margin, std::string& mtop,
         }
     }
 
-    this->bubble_.set_margin_top(mt);
-    this->bubble_.set_margin_bottom(mb);
-    this->bubble_.set_margin_start(ml);
-    this->bubble_.set_margin_end(mr);
+    std::ostringstream rule;
+    rule << "margin: " << mt << "px " << mr << "px " << mb << "px " << ml
+         << "px;";
+    this->add_rule("bubble", rule.str());
+
+    return 0;
+}
+
+/**
+ * @brief Set the duration of the fade and slide animations.
+ * 
+ * @details If a duration is not specified, read it from the config file. If a
+ *          config file from before the animations were added does not have
+ *          it, that animation is disabled, as it is with a duration of 0. A
+ *          negative duration is an error.
+ * 
+ * @param[in] fadein  Duration of the fade in, in milliseconds.
+ * @param[in] fadeout Duration of the fade out, in milliseconds.
+ * @param[in] slide   Duration of a move to a new position, in milliseconds.
+ * 
+ * @return 0 on success. Any other value indicates an error.
+ */
+int notification::set_notify_animation(std::string& fadein,
+                                       std::string& fadeout,
+                                       std::string& slide)
+{
+    if (fadein.empty() && (this->set_from_config("fade-in", fadein) < 0))
+    {
+        fadein = "0";
+    }
+    if (fadeout.empty() && (this->set_from_config("fade-out", fadeout) < 0))
+    {
+        fadeout = "0";
+    }
+    if (slide.empty() && (this->set_from_config("slide", slide) < 0))
+    {
+        slide = "0";
+    }
+    if (((this->fadeintime_=std::stoi(fadein)) < 0)
+        || ((this->fadeouttime_=std::stoi(fadeout)) < 0)
+        || ((this->slidetime_=std::stoi(slide)) < 0))
+    {
+        return -2;
+    }
+    return 0;
+}
 
+/**
+ * @brief Set the source that the progress bar is read from.
+ * 
+ * @details The progress bar is added under the title and body text, and the
+ *          source is watched from the main loop. The notification bubble stays
+ *          on screen until the source reaches its end, see restart_timeout().
+ * 
+ * @param[in] source "-" for stdin, or the path to a file or FIFO.
+ * 
+ * @return 0 on success, and -1 if the source could not be opened.
+ */
+int notification::set_notify_progress(std::string& source)
+{
+    if (progress::open(source, this->progress_) < 0)
+    {
+        return -1;
+    }
+    this->bar_.set_size_request(render::kBarWidth, render::kBarHeight);
+    this->text_.pack_end(this->bar_, Gtk::PACK_SHRINK);
+    this->add_rule("bar", "margin-top: " + std::to_string(render::kBarSpacing)
+                   + "px;");
+    this->watch_progress();
     return 0;
 }
 
@@ -773,112 +1259,233 @@ int notification::set_from_config(const std::string key, std::string& value)
 }
 
 /**
- * @brief Parse the color string and convert it to a '#123456' string if the
- *        input is a hex string.
+ * @brief Determine the monitor to display the notification bubble on.
  * 
- * @param[in] color The color hex string.
+ * @details The monitor geometry is retrieved through the connection to the X
+ *          server that GDK already has open, or from shared memory, if another
+ *          process has already retrieved it, and is cached until the monitor
+ *          layout changes. See on_monitors_changed().
  * 
- * @return The color string.
+ * @param[out] index   Index of the monitor.
+ * @param[out] monitor Position and size of the monitor.
+ * 
+ * @return 0 on success, and index and monitor will be populated. If any
+ *         other value is returned, index and monitor will be in an
+ *         undetermined state.
  */
-std::string notification::fix_color(std::string& color)
+int notification::get_monitor(int& index, struct geometry::monitor& monitor)
 {
-    if ((color.substr(0, 2) == "0x") || (color.substr(0, 2) == "0X")) {
-        color.erase(0, 2);
+    GdkDisplay* display = this->get_display()->gobj();
+    if (!GDK_IS_X11_DISPLAY(display))
+    {
+        fprintf(stderr, "%s: Not connected to an X server.\n", PROGRAM);
+        return -1;
     }
-    if (this->is_hex_color(color)) {
-        if (color[0] != '#') {
-            color.insert(0, 1, '#');
-        }
+    if (geometry::select(gdk_x11_display_get_xdisplay(display), this->monitor_,
+                         index, monitor) < 0)
+    {
+        return -2;
     }
-    return color;
+    return 0;
+}
+
+/**
+ * @brief Determine the stack that the notification bubble belongs to, from
+ *        its gravity.
+ * 
+ * @return The gravity of the stack. An unknown gravity is treated as
+ *         top-left, where the x-y positions are used as is.
+ */
+long notification::get_gravity(void)
+{
+    return geometry::gravity(this->gravity_);
 }
 
 /**
- * @brief Determine the screen resolution for monitor 0 from 
+ * @brief Turn SIGQUIT into SIGTERM, which is handled from the main loop.
  * 
- * @param[out] width  The width of the monitor.
- * @param[out] height The height of the monitor.
+ * @details GLib can not watch SIGQUIT, and a signal handler can not safely
+ *          touch shared memory, so it only raises SIGTERM, which is safe to do
+ *          from a signal handler.
  * 
- * @return 0 on success, and width and height will be populated. If any
- *         other value is returned, width and height will be in an
- *         undetermined state.
+ * @param[in] sig The signal that was captured.
  */
-int notification::get_screen_resolution(int& width, int& height)
+void notification::on_quit(int sig)
 {
-    char* display;
-    Display* xopen;
-    XRRScreenResources* screen;
-    if (!(display=getenv("DISPLAY")))
+    (void) sig;
+    raise(SIGTERM);
+}
+
+/**
+ * @brief Select the entry of the notification bubble in shared memory, before
+ *        operating on it.
+ * 
+ * @details The notification bubbles of a process that displays several share
+ *          AriaSharedMem, so each one selects its own ID and table first.
+ */
+void notification::select_entry(void)
+{
+    AriaSharedMem::identify(this->id_);
+    AriaSharedMem::select(this->index_);
+}
+
+/**
+ * @brief Add a rule to the stylesheet of the notification bubble.
+ * 
+ * @details The rule is scoped to the window, by its name, so that the
+ *          notification bubbles of a process that displays several keep their
+ *          own fonts, colors, and margins.
+ * 
+ * @param[in] name         Style class of the widget, or "aria" for the window
+ *                         itself.
+ * @param[in] declarations Declarations of the rule.
+ */
+void notification::add_rule(const std::string& name,
+                            const std::string& declarations)
+{
+    std::string selector = "#" + this->get_name().raw();
+    if (name != "aria")
     {
-        fprintf(stderr, "Get DISPLAY environment variable error.\n");
-        return -1;
+        selector += " ." + name;
+    }
+    this->stylesheet_ += selector + " { " + declarations + " }\n";
+}
+
+/**
+ * @brief Remove the notification bubble from its stack and fade it out.
+ * 
+ * @details The notification bubble is removed from shared memory first, so
+ *          that the rest of the stack slides into its place while it fades
+ *          out. Once hidden, the application exits on its own.
+ */
+void notification::dismiss(void)
+{
+    if (this->dismissed_)
+    {
+        return;
     }
-    if (!(xopen=XOpenDisplay(display)))
+    this->dismissed_ = true;
+    this->select_entry();
+    AriaSharedMem::remove(SHAREDMEM_SPACING);
+    summary::resign();
+    if ((this->fadeouttime_ > 0) && this->get_mapped())
     {
-        fprintf(stderr, "X Open Display error.\n");
-        return -2;
+        this->fade_to(0.0, this->fadeouttime_);
     }
-    auto window = DefaultRootWindow(xopen);
-    if (!(screen=XRRGetScreenResources(xopen, window)))
+    else
     {
-        fprintf(stderr, "XRR Get Screen Resources error.\n");
-        return -3;
+        this->hide();
     }
+}
 
-    /* Set screen dimensions for the monitor at x=0 */
-    int          num = screen->ncrtc;
-    int          i;
-    XRRCrtcInfo* info;
-    for (i=0; i < num; i++)
+/**
+ * @brief Move the notification bubble to a new position, sliding it there if it
+ *        is already on screen.
+ * 
+ * @details A slide that is already running continues from wherever the
+ *          notification bubble currently is.
+ * 
+ * @param[in] x X-position on the screen.
+ * @param[in] y Y-position on the screen.
+ */
+void notification::slide_to(int x, int y)
+{
+    if ((this->slidetime_ <= 0) || !this->get_mapped())
     {
-        info = XRRGetCrtcInfo(xopen, screen, screen->crtcs[i]);
-        if (info->x == 0)
-        {
-            width  = info->width;
-            height = info->height;
-            XRRFreeCrtcInfo(info);
-            break;
-        }
-        XRRFreeCrtcInfo(info);
+        this->slidex_.active = false;
+        this->slidey_.active = false;
+        this->xcur_ = x;
+        this->ycur_ = y;
+        this->move(x, y);
+        return;
     }
-    XRRFreeScreenResources(screen);
-
-    return 0;
+    if ((x == this->xcur_) && (y == this->ycur_))
+    {
+        return;
+    }
+    this->slidex_ = {-1, this->slidetime_, (double) this->xcur_, (double) x,
+                     true};
+    this->slidey_ = {-1, this->slidetime_, (double) this->ycur_, (double) y,
+                     true};
+    this->animate();
 }
 
 /**
- * @brief Check if the color string is in a hex format.
+ * @brief Fade the notification bubble to the given opacity.
  * 
- * @param[in] color The color string to check.
+ * @param[in] opacity  The final opacity of the window.
+ * @param[in] duration Duration of the fade, in milliseconds.
+ */
+void notification::fade_to(double opacity, int duration)
+{
+    this->fade_ = {-1, duration, Gtk::Widget::get_opacity(), opacity, true};
+    this->animate();
+}
+
+/**
+ * @brief Make sure that the animations are advanced on every frame.
  * 
- * @return True if the input is a color string, and false otherwise.
+ * @details The animations are driven by the frame clock of the window, rather
+ *          than a timer, so that each step is in sync with the display, and
+ *          the tick callback only exists while an animation is running.
  */
-bool notification::is_hex_color(std::string& color)
+void notification::animate(void)
 {
-    int start;
-    if (color[0] == '#') {
-        return true;
-    }
-    if (color.length() != 6) {
-        return false;
+    if (this->tick_ != 0)
+    {
+        return;
     }
-    start = 0;
-    if ((color.substr(0, 2) == "0x") || (color.substr(0, 2) == "0X")) {
-        start = 2;
+    this->lastframe_ = 0;
+    this->tick_ = this->add_tick_callback(
+        sigc::mem_fun(*this, &notification::on_tick));
+}
+
+/**
+ * @brief Print the frame statistics of the animations that just finished.
+ * 
+ * @details Only printed with --frame-stats. A frame is counted as dropped
+ *          when more than one refresh interval passes between two frames.
+ */
+void notification::report_frames(void)
+{
+    if (this->framestats_ && (this->frames_ > 0))
+    {
+        fprintf(stderr, "%s: frames: %d, dropped: %d, draw: %.3f ms avg, "
+                "%.3f ms max\n", PROGRAM, this->frames_, this->dropped_,
+                this->drawtime_/this->frames_, this->drawmax_);
     }
-    return (color.find_first_not_of("0123456789ABCDEFabcdef", start) == std::string::npos);
+    this->frames_   = 0;
+    this->dropped_  = 0;
+    this->drawtime_ = 0;
+    this->drawmax_  = 0;
 }
 
 /**
- * @brief Cleanup any memory mapped data and gracefully shutdown program.
+ * @brief Determine the value of an animation at the given frame time.
+ * 
+ * @details The animation starts on the first frame after it was created, and
+ *          eases out, so that it slows down as it reaches its final value.
  * 
- * @param[in] sig The signal that was captured, to cause the cleanup function to
- *                run.
+ * @param[in,out] t   The animation.
+ * @param[in]     now The frame time, in microseconds.
+ * 
+ * @return The value of the animation.
  */
-void notification::cleanup(int sig)
+double notification::advance(struct tween& t, gint64 now)
 {
-    AriaSharedMem::remove();
-    exit(sig);
+    if (t.start < 0)
+    {
+        t.start = now;
+    }
+    double p = (t.duration > 0) ? ((now - t.start) / (t.duration * 1000.0))
+        : 1.0;
+    if (p >= 1.0)
+    {
+        t.active = false;
+        return t.to;
+    }
+    p = 1.0 - std::pow(1.0 - p, 3);
+    return t.from + ((t.to - t.from) * p);
 }
 
 /**
@@ -890,6 +1497,7 @@ void notification::cleanup(int sig)
  */
 bool notification::on_draw(const Cairo::RefPtr<Cairo::Context>& cr)
 {
+    double start = util::now();
     Glib::RefPtr<Gdk::Screen> screen = this->get_screen();
     double width  = this->width_;
     double height = this->height_;
@@ -914,7 +1522,382 @@ bool notification::on_draw(const Cairo::RefPtr<Cairo::Context>& cr)
     }
     cr->fill_preserve();
     cr->stroke();
-    return Gtk::Window::on_draw(cr);
+    bool status = Gtk::Window::on_draw(cr);
+    render::draw_badge(cr->cobj(), this->count_, this->width_, this->curve_);
+    if (this->tick_ != 0)
+    {
+        double elapsed = util::now() - start;
+        this->drawtime_ += elapsed;
+        this->drawmax_   = std::max(this->drawmax_, elapsed);
+    }
+    return status;
+}
+
+/**
+ * @brief Advance the animations to the time of the current frame.
+ * 
+ * @details When every animation has finished, the tick callback is removed,
+ *          and if the notification bubble was dismissed, it is hidden.
+ * 
+ * @param[in] clock The frame clock of the window.
+ * 
+ * @return True while an animation is running, and false otherwise.
+ */
+bool notification::on_tick(const Glib::RefPtr<Gdk::FrameClock>& clock)
+{
+    gint64 now = clock->get_frame_time();
+    gint64 refresh = 0;
+    gint64 presentation = 0;
+    if (this->lastframe_ > 0)
+    {
+        clock->get_refresh_info(now, &refresh, &presentation);
+        if (refresh > 0)
+        {
+            gint64 missed = ((now - this->lastframe_ + (refresh / 2)) / refresh)
+                - 1;
+            this->dropped_ += std::max<gint64>(missed, 0);
+        }
+    }
+    this->lastframe_ = now;
+    ++this->frames_;
+
+    if (this->fade_.active)
+    {
+        Gtk::Widget::set_opacity(this->advance(this->fade_, now));
+    }
+    if (this->slidex_.active || this->slidey_.active)
+    {
+        this->xcur_ = std::lround(this->advance(this->slidex_, now));
+        this->ycur_ = std::lround(this->advance(this->slidey_, now));
+        this->move(this->xcur_, this->ycur_);
+    }
+    if (this->fade_.active || this->slidex_.active || this->slidey_.active)
+    {
+        return true;
+    }
+
+    this->tick_ = 0;
+    this->report_frames();
+    if (this->dismissed_)
+    {
+        this->hide();
+    }
+    return false;
+}
+
+/**
+ * @brief Watch the source of the progress bar for updates.
+ */
+void notification::watch_progress(void)
+{
+    Glib::signal_io().connect(sigc::mem_fun(*this, &notification::on_progress),
+                              this->progress_.fd,
+                              Glib::IO_IN | Glib::IO_HUP | Glib::IO_ERR);
+}
+
+/**
+ * @brief Read the updates of the progress bar that are waiting.
+ * 
+ * @details The source stops being watched until the next frame, when
+ *          on_progress_tick() displays the latest update and watches it again.
+ *          However fast the updates are written, the source is read, and the
+ *          bar drawn, at most once per frame, and the updates in between are
+ *          left in the pipe and skipped over in one read. When the source
+ *          reaches its end, the timeout starts.
+ * 
+ * @param[in] condition The condition of the source.
+ * 
+ * @return False, to stop watching the source.
+ */
+bool notification::on_progress(Glib::IOCondition condition)
+{
+    if (this->dismissed_)
+    {
+        return false;
+    }
+    progress::read(this->progress_);
+    if (this->progress_.eof)
+    {
+        this->restart_timeout();
+    }
+    if (this->progresstick_ == 0)
+    {
+        this->progresstick_ = this->add_tick_callback(
+            sigc::mem_fun(*this, &notification::on_progress_tick));
+    }
+    return false;
+}
+
+/**
+ * @brief Display the latest update of the progress bar.
+ * 
+ * @details Only the area of the progress bar is redrawn when the fraction
+ *          changes. New text replaces the body, which is a single line that
+ *          does not resize the notification bubble once it exists.
+ * 
+ * @param[in] clock The frame clock of the window.
+ * 
+ * @return False, to remove the tick callback.
+ */
+bool notification::on_progress_tick(const Glib::RefPtr<Gdk::FrameClock>& clock)
+{
+    struct SharedMemPayload p = {};
+    if (this->fraction_ != this->progress_.fraction)
+    {
+        this->fraction_ = this->progress_.fraction;
+        this->bar_.queue_draw();
+    }
+    if (this->progress_.newtext)
+    {
+        this->progress_.newtext = false;
+        if (this->body_)
+        {
+            this->set_label_text(this->body_, this->progress_.text);
+        }
+        else
+        {
+            strncpy(p.body, this->progress_.text.c_str(), sizeof(p.body)-1);
+            p.fields = SHAREDMEM_FIELD_BODY;
+            this->replace(p);
+        }
+    }
+    this->progresstick_ = 0;
+    if (!this->progress_.eof && !this->dismissed_)
+    {
+        this->watch_progress();
+    }
+    return false;
+}
+
+/**
+ * @brief Draw the progress bar.
+ * 
+ * @param[in] cr Cairo drawing context.
+ * 
+ * @return True, as nothing else is drawn in the progress bar.
+ */
+bool notification::on_bar_draw(const Cairo::RefPtr<Cairo::Context>& cr)
+{
+    render::draw_bar(cr->cobj(), 0, 0, this->bar_.get_allocated_width(),
+                     this->bar_.get_allocated_height(), this->fraction_,
+                     *this->foreground_.gobj());
+    return true;
+}
+
+/**
+ * @brief Move to the position in shared memory, after another notification
+ *        bubble in the same stack was removed.
+ * 
+ * @details Runs from the main loop when SIGUSR1 is received, see
+ *          AriaSharedMem::notify(). One of several notification bubbles in a
+ *          process whose entry is gone was evicted, see AriaSharedMem::evict(),
+ *          and is dismissed, unless it never had an entry.
+ * 
+ * @param[in] data The notification bubble.
+ * 
+ * @return G_SOURCE_CONTINUE, to keep handling the signal.
+ */
+gboolean notification::on_reflow(gpointer data)
+{
+    notification* self = static_cast<notification*>(data);
+    struct SharedMemType entry;
+    if (self->dismissed_)
+    {
+        return G_SOURCE_CONTINUE;
+    }
+    if (AriaSharedMem::lookup(self->index_, self->id_, &entry) == 0)
+    {
+        self->slide_to(entry.x, entry.y);
+    }
+    else if ((self->id_ != SHAREDMEM_PID(self->id_)) && self->placed_
+             && self->get_mapped())
+    {
+        self->dismiss();
+    }
+    return G_SOURCE_CONTINUE;
+}
+
+/**
+ * @brief Dismiss the notification bubble, after the process was told to quit.
+ * 
+ * @details Runs from the main loop when SIGINT or SIGTERM is received, e.g.
+ *          when AriaSharedMem::evict() makes room for a more urgent
+ *          notification, so that shared memory is only touched outside of a
+ *          signal handler. The process exits once the notification bubble is
+ *          hidden.
+ * 
+ * @param[in] data The notification bubble.
+ * 
+ * @return G_SOURCE_CONTINUE, to keep handling the signal.
+ */
+gboolean notification::on_terminate(gpointer data)
+{
+    static_cast<notification*>(data)->dismiss();
+    return G_SOURCE_CONTINUE;
+}
+
+/**
+ * @brief Show the new repeat count or contents, and restart the timeout, after
+ *        a duplicate or a replacement of the notification was sent.
+ * 
+ * @details Runs from the main loop when SIGUSR2 is received, see
+ *          AriaSharedMem::coalesce(), AriaSharedMem::deliver(), and
+ *          AriaSharedMem::fold(). The count and contents are read from shared
+ *          memory, so that signals that arrive together are not lost.
+ * 
+ * @param[in] data The notification bubble.
+ * 
+ * @return G_SOURCE_CONTINUE, to keep handling the signal.
+ */
+gboolean notification::on_repeat(gpointer data)
+{
+    notification* self = static_cast<notification*>(data);
+    struct SharedMemType entry;
+    struct SharedMemPayload payload;
+    bool changed = false;
+    if (self->dismissed_)
+    {
+        return G_SOURCE_CONTINUE;
+    }
+    self->select_entry();
+    if ((AriaSharedMem::collect(self->tagkey_, &self->seen_, &payload) == 0)
+        || summary::collect(payload))
+    {
+        self->replace(payload);
+        changed = true;
+    }
+    if ((AriaSharedMem::lookup(self->index_, self->id_, &entry) == 0)
+        && (entry.count != self->count_))
+    {
+        self->count_ = entry.count;
+        self->queue_draw();
+        changed = true;
+    }
+    if (changed)
+    {
+        self->restart_timeout();
+    }
+    return G_SOURCE_CONTINUE;
+}
+
+/**
+ * @brief Replace the title, body, or icon, with new contents that were handed
+ *        to the notification bubble by tag.
+ * 
+ * @details Labels and icons are updated in place. One that the notification
+ *          bubble was built without is added, the same way as when it is
+ *          built. The notification bubble is measured again, unless its size
+ *          was given, and is only placed again if its size changed, which
+ *          keeps its place in the stack and moves the rest of it.
+ * 
+ * @param[in] p The new contents.
+ */
+void notification::replace(const struct SharedMemPayload& p)
+{
+    std::string text;
+    std::string spacing;
+    int oldwidth = this->width_;
+    int oldheight = this->height_;
+    int width;
+    int height;
+    if (p.fields & SHAREDMEM_FIELD_TITLE)
+    {
+        text = p.title;
+        if (this->title_)
+        {
+            this->set_label_text(this->title_, text);
+        }
+        else
+        {
+            this->set_title(text, this->font_, this->titlesize_);
+        }
+    }
+    if (p.fields & SHAREDMEM_FIELD_BODY)
+    {
+        text = p.body;
+        if (this->body_)
+        {
+            this->set_label_text(this->body_, text);
+        }
+        else
+        {
+            this->set_body(text, this->font_, this->bodysize_);
+        }
+    }
+    if (p.fields & SHAREDMEM_FIELD_ICON)
+    {
+        text = p.icon;
+        if (this->image_)
+        {
+            this->image_->set(text);
+        }
+        else
+        {
+            this->set_notify_icon(text, spacing);
+        }
+    }
+    this->apply_style();
+    this->show_all_children();
+
+    this->measure(width, height);
+    if (this->autowidth_)
+    {
+        this->width_ = width;
+    }
+    if (this->autoheight_)
+    {
+        this->height_ = height;
+    }
+    if ((this->width_ != oldwidth) || (this->height_ != oldheight))
+    {
+        this->set_size_request(this->width_, this->height_);
+        Gtk::Window::resize(this->width_, this->height_);
+        this->reposition();
+    }
+    this->queue_draw();
+}
+
+/**
+ * @brief Query the monitor geometry again, when GDK receives a RandR event
+ *        indicating that the monitor layout changed, and publish it for other
+ *        processes.
+ */
+void notification::on_monitors_changed(void)
+{
+    GdkDisplay* display = this->get_display()->gobj();
+    if (GDK_IS_X11_DISPLAY(display))
+    {
+        geometry::refresh(gdk_x11_display_get_xdisplay(display));
+    }
+}
+
+/**
+ * @brief Query the monitor geometry again, when the work area changes because a
+ *        panel or dock was added, removed, or resized, and place the
+ *        notification bubble again.
+ * 
+ * @param[in] xevent The X event received on the root window.
+ * @param[in] event  The GDK event, unused.
+ * @param[in] data   The notification bubble.
+ * 
+ * @return GDK_FILTER_CONTINUE, so that GDK still handles the event.
+ */
+GdkFilterReturn notification::on_root_event(GdkXEvent* xevent, GdkEvent* event,
+                                            gpointer data)
+{
+    notification* self = static_cast<notification*>(data);
+    GdkDisplay* display = self->get_display()->gobj();
+    if (GDK_IS_X11_DISPLAY(display))
+    {
+        Display* xdisplay = gdk_x11_display_get_xdisplay(display);
+        if (!self->dismissed_
+            && geometry::is_workarea_event(xdisplay, (XEvent*) xevent))
+        {
+            geometry::refresh(xdisplay);
+            self->reposition();
+        }
+    }
+    return GDK_FILTER_CONTINUE;
 }
 
 /**
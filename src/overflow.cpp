@@ -0,0 +1,133 @@
+/**
+ * @file overflow.cpp
+ * @author Gabriel Gonzalez
+ * 
+ * @brief Decide what to do with a notification when its stack is full.
+ */
+
+#include "overflow.hpp"
+#include "config.hpp"
+#include "geometry.hpp"
+#include "sharedmem.hpp"
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+ARIA_NAMESPACE
+
+/**
+ * @brief Determine the urgency of a notification.
+ * 
+ * @param[in] cli The command line interface.
+ * 
+ * @return The urgency, see SharedMemUrgency, or -1 if it is invalid.
+ */
+long overflow::urgency(commandline::interface& cli)
+{
+    std::string level = cli.get("urgency");
+    if (level.empty())
+    {
+        level = config::read("urgency");
+    }
+    if (level == "low")
+    {
+        return SHAREDMEM_URGENCY_LOW;
+    }
+    if ((level == "normal") || level.empty())
+    {
+        return SHAREDMEM_URGENCY_NORMAL;
+    }
+    if (level == "critical")
+    {
+        return SHAREDMEM_URGENCY_CRITICAL;
+    }
+    return -1;
+}
+
+/**
+ * @brief Make sure that the stack of the notification has room for it.
+ * 
+ * @details The stack is that of the monitor guessed from the geometry in
+ *          shared memory, as the X server is not connected to yet. When every
+ *          notification in the stack is more urgent, replace-oldest waits, as
+ *          with wait. The room is claimed under the lock of the table, so
+ *          that another notification can not take it first, and the
+ *          notification fills in its place once it knows its size.
+ * 
+ * @param[in] cli The command line interface.
+ * 
+ * @return 0 if the notification may be displayed, and 12 if it was discarded.
+ */
+int overflow::admit(commandline::interface& cli)
+{
+    std::string policy = cli.get("on-full");
+    std::string spec = cli.get("monitor");
+    std::string maxwait = cli.get("max-wait");
+    long level = overflow::urgency(cli);
+    geometry::monitorlist_t monitors;
+    int index = 0;
+    if (policy.empty())
+    {
+        policy = config::read("on-full");
+    }
+    if (spec.empty())
+    {
+        spec = config::read("monitor");
+    }
+    if (maxwait.empty())
+    {
+        maxwait = config::read("max-wait");
+    }
+    if ((policy != "drop") && (policy != "wait")
+        && (policy != "replace-oldest"))
+    {
+        fprintf(stderr, "%s: Invalid policy for a full stack '%s'.\n", PROGRAM,
+                policy.c_str());
+        return 12;
+    }
+    if (level < 0)
+    {
+        fprintf(stderr, "%s: Invalid urgency '%s'.\n", PROGRAM,
+                cli.get("urgency").c_str());
+        return 12;
+    }
+    if (geometry::peek(monitors) == 0)
+    {
+        index = geometry::guess(spec, monitors);
+    }
+    if (AriaSharedMem::claim(index, level) != 1)
+    {
+        return 0;
+    }
+
+    if ((level == SHAREDMEM_URGENCY_CRITICAL)
+        && (AriaSharedMem::evict(index, SHAREDMEM_SPACING,
+                                 SHAREDMEM_URGENCY_NORMAL, level) == 0))
+    {
+        return 0;
+    }
+    if ((policy == "replace-oldest")
+        && (AriaSharedMem::evict(index, SHAREDMEM_SPACING, level,
+                                 level) == 0))
+    {
+        return 0;
+    }
+    if (policy != "drop")
+    {
+        double seconds = std::strtod(maxwait.c_str(), NULL);
+        long timeout = (seconds > 0) ? std::lround(seconds * 1000.0) : 0;
+        if (AriaSharedMem::waitfree(index, level, timeout) != 1)
+        {
+            return 0;
+        }
+        fprintf(stderr, "%s: Timed out waiting for room in the stack.\n",
+                PROGRAM);
+        return 12;
+    }
+    fprintf(stderr, "%s: The stack is full, dropping this notification.\n",
+            PROGRAM);
+    return 12;
+}
+
+ARIA_NAMESPACE_END
@@ -0,0 +1,222 @@
+/**
+ * @file progress.cpp
+ * @author Gabriel Gonzalez
+ * 
+ * @brief Read the updates of a progress bar from a pipe or a file.
+ */
+
+#include "progress.hpp"
+#include <fcntl.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <cstdlib>
+#include <string>
+
+ARIA_NAMESPACE
+
+/**
+ * @brief Maximum length of a line that is kept. Anything past it is dropped.
+ */
+static const size_t kLineLength = 4096;
+
+/**
+ * @brief Maximum number of chunks that are read at once, so that a producer
+ *        that writes faster than the input is read can not stall the event
+ *        loop. What is left is read on the next frame.
+ */
+static const int kChunks = 16;
+
+/**
+ * @brief Find the last line break in a chunk of input.
+ * 
+ * @details Both '\\n' and '\\r' end a line, so that progress meters that
+ *          redraw a single terminal line can be piped in as well.
+ * 
+ * @param[in] begin Start of the chunk.
+ * @param[in] end   End of the chunk.
+ * 
+ * @return The last line break, or NULL if there is none.
+ */
+static const char* last_break(const char* begin, const char* end)
+{
+    while (end > begin)
+    {
+        --end;
+        if ((*end == '\n') || (*end == '\r'))
+        {
+            return end;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief Parse a line of the form "PERCENT[%] [TEXT]".
+ * 
+ * @details Leading brackets are skipped, so that the "[ 42%] Building ..."
+ *          lines that CMake prints can be piped in as they are. A line that
+ *          does not start with a number only updates the text, and one
+ *          without text only updates the bar.
+ * 
+ * @param[in]     line The line.
+ * @param[in,out] s    The stream.
+ * 
+ * @return True if the fraction or the text changed, and false otherwise.
+ */
+static bool parse(const std::string& line, struct progress::stream& s)
+{
+    const char* p = line.c_str();
+    char* end;
+    bool changed = false;
+    while ((*p == ' ') || (*p == '\t') || (*p == '['))
+    {
+        ++p;
+    }
+    if (std::isdigit((unsigned char) *p) || (*p == '.'))
+    {
+        double fraction = std::strtod(p, &end) / 100.0;
+        fraction = std::min(std::max(fraction, 0.0), 1.0);
+        if (fraction != s.fraction)
+        {
+            s.fraction = fraction;
+            changed = true;
+        }
+        for (p=end; (*p == '%') || (*p == ']') || (*p == ' ') || (*p == '\t');
+             ++p)
+        {
+        }
+    }
+    else
+    {
+        p = line.c_str();
+    }
+    if ((*p != '\0') && (s.text != p))
+    {
+        s.text = p;
+        s.newtext = true;
+        changed = true;
+    }
+    return changed;
+}
+
+/**
+ * @brief Open the source of the updates.
+ * 
+ * @details The source is read without blocking, so that it can be watched
+ *          from the event loop of the notification bubble.
+ * 
+ * @param[in]  source "-" for stdin, or the path to a file or FIFO.
+ * @param[out] s      The stream.
+ * 
+ * @return 0 on success, and -1 if the source could not be opened.
+ */
+int progress::open(const std::string& source, struct stream& s)
+{
+    s = {};
+    s.fd = -1;
+    if (source == "-")
+    {
+        int flags = fcntl(STDIN_FILENO, F_GETFL);
+        if ((flags < 0)
+            || (fcntl(STDIN_FILENO, F_SETFL, flags | O_NONBLOCK) < 0))
+        {
+            return -1;
+        }
+        s.fd = STDIN_FILENO;
+    }
+    else if ((s.fd=::open(source.c_str(), O_RDONLY | O_NONBLOCK | O_CLOEXEC))
+             < 0)
+    {
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * @brief Read everything that is waiting on the source, without blocking, and
+ *        keep the latest update.
+ * 
+ * @details The input is read in chunks as large as a pipe buffer. Only the
+ *          last complete line of each chunk is looked at, by searching back
+ *          from its end, so the cost per byte is a copy, however many updates
+ *          the chunk holds. A line that is not complete is kept for the next
+ *          read, up to kLineLength.
+ * 
+ * @param[in,out] s The stream.
+ * 
+ * @return True if the fraction or the text changed, and false otherwise.
+ */
+bool progress::read(struct stream& s)
+{
+    char buf[65536];
+    std::string line;
+    bool complete = false;
+    ssize_t n = -1;
+    if (s.fd < 0)
+    {
+        return false;
+    }
+    for (int i = 0; (i < kChunks) && ((n=::read(s.fd, buf, sizeof(buf))) > 0);
+         ++i)
+    {
+        const char* tail = last_break(buf, buf+n);
+        const char* end = tail;
+        if (!tail)
+        {
+            s.partial.append(buf, std::min((size_t) n, kLineLength
+                                           - std::min(s.partial.size(),
+                                                      kLineLength)));
+            continue;
+        }
+        const char* start = last_break(buf, end);
+        while (start && (start+1 == end))
+        {
+            end   = start;
+            start = last_break(buf, end);
+        }
+        if (start)
+        {
+            line.assign(start+1, end);
+        }
+        else
+        {
+            line = s.partial;
+            line.append(buf, end-buf);
+        }
+        if (!line.empty())
+        {
+            line.resize(std::min(line.size(), kLineLength));
+            complete = parse(line, s) || complete;
+        }
+        s.partial.assign(tail+1, std::min((size_t) (buf+n-tail-1),
+                                          kLineLength));
+    }
+    if ((n == 0) || ((n < 0) && (errno != EAGAIN) && (errno != EINTR)))
+    {
+        s.eof = true;
+        if (!s.partial.empty())
+        {
+            complete = parse(s.partial, s) || complete;
+            s.partial.clear();
+        }
+    }
+    return complete;
+}
+
+/**
+ * @brief Close the source of the updates.
+ * 
+ * @param[in,out] s The stream.
+ */
+void progress::close(struct stream& s)
+{
+    if (s.fd >= 0)
+    {
+        ::close(s.fd);
+    }
+    s.fd = -1;
+}
+
+ARIA_NAMESPACE_END
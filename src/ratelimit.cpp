@@ -0,0 +1,81 @@
+/**
+ * @file ratelimit.cpp
+ * @author Gabriel Gonzalez
+ * 
+ * @brief Limit the rate of notifications across every running process.
+ */
+
+#include "ratelimit.hpp"
+#include "config.hpp"
+#include "sharedmem.hpp"
+#include "util.hpp"
+#include <cmath>
+#include <cstdlib>
+#include <string>
+
+ARIA_NAMESPACE
+
+/**
+ * @brief Check whether a notification may be displayed.
+ * 
+ * @details A token is taken from the shared bucket first, so that no token of
+ *          the title is used up when the shared bucket is empty. A
+ *          notification without a title has no bucket of its own, as every
+ *          such notification would share it. The config file is loaded here,
+ *          which is cheap, so that the check is done before the toolkit, the
+ *          X server, or the lock on shared memory are touched.
+ * 
+ * @param[in] cli The command line interface.
+ * 
+ * @return True if the notification may be displayed, and false if it is over
+ *         budget.
+ */
+bool ratelimit::allow(commandline::interface& cli)
+{
+    std::string title = cli.get("title");
+    if (title.empty())
+    {
+        title = config::read("title");
+    }
+    if (!ratelimit::take(0, "rate", "burst"))
+    {
+        return false;
+    }
+    if (title.empty())
+    {
+        return true;
+    }
+    unsigned long key = util::hash(title);
+    return ratelimit::take((key != 0) ? key : 1, "title-rate", "title-burst");
+}
+
+/**
+ * @brief Take a token from a bucket.
+ * 
+ * @details A bucket whose rate is not set, or is 0, always has a token. The
+ *          size of a bucket is at least one token.
+ * 
+ * @param[in] key       Key of the bucket, or 0 for the shared one.
+ * @param[in] ratekey   Config key of the rate of the bucket, in notifications
+ *                      per second.
+ * @param[in] burstkey  Config key of the size of the bucket, in
+ *                      notifications.
+ * 
+ * @return True if a token was taken, or if the bucket could not be checked,
+ *         and false if the bucket is empty.
+ */
+bool ratelimit::take(unsigned long key, const char* ratekey,
+                     const char* burstkey)
+{
+    double rate = std::strtod(config::read(ratekey).c_str(), NULL);
+    long burst = std::strtol(config::read(burstkey).c_str(), NULL, 10);
+    if (!(rate > 0))
+    {
+        return true;
+    }
+    long interval = std::lround(1000.0 / rate);
+    return AriaSharedMem::take(key, (interval > 0) ? interval : 1,
+                               (burst > 0) ? burst : 1) != 1;
+}
+
+ARIA_NAMESPACE_END
@@ -0,0 +1,674 @@
+/**
+ * @file render.cpp
+ * @author Gabriel Gonzalez
+ * 
+ * @brief Lay out and draw a notification bubble with Cairo and Pango, without
+ *        a connection to a display.
+ */
+
+#include "render.hpp"
+#include "config.hpp"
+#include "util.hpp"
+#include <sys/stat.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <string>
+
+ARIA_NAMESPACE
+
+/**
+ * @brief Get the value of an option from the command line, or from the config
+ *        file if it was not entered.
+ * 
+ * @param[in] cli The command line interface.
+ * @param[in] key The name of the option.
+ * 
+ * @return The value of the option, which is empty if it was not found.
+ */
+static std::string get_value(commandline::interface& cli, const char* key)
+{
+    std::string value = cli.get(key);
+    if (value.empty())
+    {
+        value = config::read(key);
+    }
+    return value;
+}
+
+/**
+ * @brief Convert the value of an option to an integer.
+ * 
+ * @param[in] value The value of the option.
+ * 
+ * @return The integer, or 0 if the value is empty.
+ */
+static int to_int(const std::string& value)
+{
+    return value.empty() ? 0 : std::stoi(value);
+}
+
+/**
+ * @brief Create the layout of the title or body text.
+ * 
+ * @details The text is prepared the same way as a label in the notification
+ *          bubble window: it is normalized, parsed as markup, unless it is
+ *          plain, and truncated. The line width and number of lines are then
+ *          limited the same way that GTK limits a label.
+ * 
+ * @param[in] cr   The Cairo context that the text will be drawn with.
+ * @param[in] s    The settings of the bubble.
+ * @param[in] text The title or body text.
+ * @param[in] size The font size of the text.
+ * 
+ * @return The layout, or NULL if there is no text.
+ */
+static PangoLayout* create_text(cairo_t* cr, const struct render::settings& s,
+                                std::string text, int size)
+{
+    if (text.empty())
+    {
+        return NULL;
+    }
+
+    PangoLayout* layout = pango_cairo_create_layout(cr);
+    PangoFontDescription* desc = pango_font_description_new();
+    pango_font_description_set_family(desc, s.font.c_str());
+    pango_font_description_set_size(desc, size*PANGO_SCALE);
+    pango_layout_set_font_description(layout, desc);
+
+    PangoAttrList* attrs = NULL;
+    text = util::normalize(text);
+    if (!s.plain)
+    {
+        util::parse_markup(text, &attrs);
+    }
+    util::truncate(text, s.maxlines, s.maxwidth);
+    pango_layout_set_text(layout, text.c_str(), -1);
+    pango_layout_set_attributes(layout, attrs);
+    if (attrs)
+    {
+        pango_attr_list_unref(attrs);
+    }
+
+    pango_layout_set_wrap(layout, PANGO_WRAP_WORD);
+    if (s.maxwidth > 0)
+    {
+        PangoFontMetrics* metrics = pango_context_get_metrics(
+            pango_layout_get_context(layout), desc, NULL);
+        int charwidth = std::max(
+            pango_font_metrics_get_approximate_char_width(metrics),
+            pango_font_metrics_get_approximate_digit_width(metrics));
+        pango_font_metrics_unref(metrics);
+        pango_layout_set_width(layout, s.maxwidth*charwidth);
+    }
+    if (s.maxlines > 0)
+    {
+        pango_layout_set_height(layout, -s.maxlines);
+        pango_layout_set_ellipsize(layout, PANGO_ELLIPSIZE_END);
+    }
+    pango_font_description_free(desc);
+    return layout;
+}
+
+/**
+ * @brief Estimate the size of the title or body text from its length.
+ * 
+ * @details Characters are taken to be slightly over half as wide as the font
+ *          size, and lines slightly taller, which is close for the sans-serif
+ *          fonts that are typically used. Lines are wrapped at the maximum
+ *          width, and their number limited to the maximum number of lines.
+ * 
+ * @param[in]  s      The settings of the bubble.
+ * @param[in]  text   The title or body text.
+ * @param[in]  size   The font size of the text.
+ * @param[out] width  The estimated width.
+ * @param[out] height The estimated height.
+ */
+static void estimate_text(const struct render::settings& s, std::string text,
+                          int size, int& width, int& height)
+{
+    double px = size * 96.0 / 72.0;
+    int columns = 0;
+    int lines = 0;
+    int length = 0;
+    width  = 0;
+    height = 0;
+    if (text.empty())
+    {
+        return;
+    }
+
+    text = util::normalize(text);
+    if (!s.plain)
+    {
+        util::parse_markup(text, NULL);
+    }
+    util::truncate(text, s.maxlines, s.maxwidth);
+    text += '\n';
+    for (unsigned char c : text)
+    {
+        if (c == '\n')
+        {
+            int wrapped = ((s.maxwidth > 0) && (length > s.maxwidth))
+                ? ((length + s.maxwidth - 1) / s.maxwidth) : 1;
+            columns = std::max(columns, (s.maxwidth > 0)
+                               ? std::min(length, s.maxwidth) : length);
+            lines  += wrapped;
+            length  = 0;
+        }
+        else if ((c & 0xC0) != 0x80)
+        {
+            ++length;
+        }
+    }
+    if ((s.maxlines > 0) && (lines > s.maxlines))
+    {
+        lines = s.maxlines;
+    }
+    width  = std::lround(columns * px * 0.55);
+    height = std::lround(lines * px * 1.25);
+}
+
+/**
+ * @brief Check that the icon of a notification bubble exists.
+ * 
+ * @details Both notification::build() and resolve() make this check, so that
+ *          a bubble rendered with --render-to accepts the same icons as the
+ *          one on screen.
+ * 
+ * @param[in] path Path to the icon, or empty if there is none.
+ * 
+ * @return True if there is no icon, or if it exists, and false otherwise.
+ */
+bool render::check_icon(const std::string& path)
+{
+    struct stat statbuf;
+    return path.empty() || (stat(path.c_str(), &statbuf) == 0);
+}
+
+/**
+ * @brief Parse the opacity of a notification bubble.
+ * 
+ * @param[in]  opacity The opacity, as it was entered.
+ * @param[out] alpha   The parsed opacity.
+ * 
+ * @return True if the opacity is between 0 and 1, and false otherwise.
+ */
+bool render::parse_opacity(const std::string& opacity, double& alpha)
+{
+    if (opacity.empty())
+    {
+        return false;
+    }
+    alpha = std::stod(opacity);
+    return (alpha >= 0) && (alpha <= 1);
+}
+
+/**
+ * @brief Resolve the settings of a notification bubble.
+ * 
+ * @details Each attribute is taken from the command line, or from the config
+ *          file if it was not entered, and checked the same way that
+ *          notification::build() checks it.
+ * 
+ * @param[in]  cli The command line interface.
+ * @param[out] s   The resolved settings.
+ * 
+ * @return 0 on success. Any other value is an error, using the same values as
+ *         notification::build().
+ */
+int render::resolve(commandline::interface& cli, struct settings& s)
+{
+    std::string background = get_value(cli, "background");
+    std::string foreground = get_value(cli, "foreground");
+    std::string opacity    = get_value(cli, "opacity");
+    std::string margin     = cli.get("margin");
+    std::string value;
+
+    s.title     = cli.get("title");
+    s.body      = cli.get("body");
+    s.font      = get_value(cli, "font");
+    s.titlesize = to_int(get_value(cli, "title-size"));
+    s.bodysize  = to_int(get_value(cli, "body-size"));
+    s.maxlines  = to_int(get_value(cli, "max-lines"));
+    s.maxwidth  = to_int(get_value(cli, "max-width"));
+    s.plain     = cli.has("plain");
+    if ((s.title.empty() && s.body.empty() && !cli.has("progress"))
+        || s.font.empty()
+        || (s.titlesize <= 0) || (s.bodysize <= 0) || (s.maxlines < 0)
+        || (s.maxwidth < 0))
+    {
+        return 1;
+    }
+
+    s.icon    = get_value(cli, "icon");
+    s.spacing = to_int(get_value(cli, "icon-text-spacing"));
+    if (!render::check_icon(s.icon) || (s.spacing < 0))
+    {
+        return 2;
+    }
+
+    s.progress = cli.has("progress") ? 0.0 : -1.0;
+    s.time = to_int(get_value(cli, "time"));
+    if (s.time <= 0)
+    {
+        return 2;
+    }
+    s.count = 1;
+
+    s.width  = to_int(get_value(cli, "width"));
+    s.height = to_int(get_value(cli, "height"));
+    if ((s.width < 0) || (s.height < 0))
+    {
+        return 3;
+    }
+
+    s.xpos    = to_int(cli.get("xpos"));
+    s.ypos    = to_int(cli.get("ypos"));
+    s.gravity = get_value(cli, "gravity");
+    s.monitor = get_value(cli, "monitor");
+    if (s.gravity.empty())
+    {
+        return 4;
+    }
+    if (s.monitor.empty())
+    {
+        s.monitor = "primary";
+    }
+
+    if (background.empty() || foreground.empty()
+        || !gdk_rgba_parse(&s.background, util::fix_color(background).c_str())
+        || !gdk_rgba_parse(&s.foreground, util::fix_color(foreground).c_str())
+        || !render::parse_opacity(opacity, s.background.alpha))
+    {
+        return 5;
+    }
+
+    s.curve = to_int(get_value(cli, "curve"));
+    if (s.curve < 0)
+    {
+        return 6;
+    }
+
+    const char* keys[] = {"margin-top", "margin-right", "margin-bottom",
+                          "margin-left"};
+    for (int i = 0; i < 4; ++i)
+    {
+        value = margin.empty() ? get_value(cli, keys[i]) : margin;
+        if ((s.margin[i]=to_int(value)) < 0)
+        {
+            return 7;
+        }
+    }
+    return 0;
+}
+
+/**
+ * @brief Lay out a notification bubble.
+ * 
+ * @details The icon and text are placed side by side, separated by the
+ *          spacing, and both are centered vertically. If the width or height
+ *          is not set, the bubble is sized to fit its contents, plus the
+ *          curvature of its corners, as the notification bubble window is.
+ * 
+ *          A progress bar goes under the text. The text is then as wide as the
+ *          title or the bar, and the body is a single line, ellipsized to fit,
+ *          so that updating it does not resize the bubble.
+ * 
+ * @param[in]  cr The Cairo context that the bubble will be drawn with.
+ * @param[in]  s  The settings of the bubble.
+ * @param[out] l  The layout of the bubble.
+ * 
+ * @return 0 on success, and -1 if the icon could not be loaded.
+ */
+int render::lay_out(cairo_t* cr, const struct settings& s, struct layout& l)
+{
+    int titlew = 0;
+    int titleh = 0;
+    int bodyw  = 0;
+    int bodyh  = 0;
+    int iconw  = 0;
+    int iconh  = 0;
+    int gap    = 0;
+
+    l = {};
+    l.title = create_text(cr, s, s.title, s.titlesize);
+    l.body  = create_text(cr, s, s.body, s.bodysize);
+    if (!s.icon.empty())
+    {
+        GError* err = NULL;
+        if (!(l.icon=gdk_pixbuf_new_from_file(s.icon.c_str(), &err)))
+        {
+            g_error_free(err);
+            return -1;
+        }
+        iconw = gdk_pixbuf_get_width(l.icon);
+        iconh = gdk_pixbuf_get_height(l.icon);
+        gap   = s.spacing;
+    }
+    if (l.title)
+    {
+        pango_layout_get_pixel_size(l.title, &titlew, &titleh);
+    }
+    if (l.body)
+    {
+        pango_layout_get_pixel_size(l.body, &bodyw, &bodyh);
+    }
+
+    int textw   = std::max(titlew, bodyw);
+    int texth   = titleh + bodyh;
+    if (s.progress >= 0)
+    {
+        textw   = std::max(titlew, kBarWidth);
+        texth  += kBarSpacing + kBarHeight;
+        l.barw  = textw;
+        if (l.body)
+        {
+            pango_layout_set_width(l.body, textw*PANGO_SCALE);
+            pango_layout_set_height(l.body, -1);
+            pango_layout_set_ellipsize(l.body, PANGO_ELLIPSIZE_END);
+            pango_layout_get_pixel_size(l.body, &bodyw, &bodyh);
+            texth = titleh + bodyh + kBarSpacing + kBarHeight;
+        }
+    }
+    int inner   = std::max(iconh, texth);
+    int width   = s.margin[3] + iconw + gap + textw + s.margin[1];
+    int height  = s.margin[0] + inner + s.margin[2];
+    l.width     = (s.width > 0) ? s.width : (width + s.curve);
+    l.height    = (s.height > 0) ? s.height : (height + s.curve);
+    int x       = (l.width - width) / 2;
+    int y       = (l.height - height) / 2;
+    l.iconx     = x + s.margin[3];
+    l.icony     = y + s.margin[0] + ((inner - iconh) / 2);
+    l.textx     = l.iconx + iconw + gap;
+    l.texty     = y + s.margin[0] + ((inner - texth) / 2);
+    l.titleh    = titleh;
+    l.barx      = l.textx;
+    l.bary      = l.texty + titleh + bodyh + kBarSpacing;
+    return 0;
+}
+
+/**
+ * @brief Estimate the size of a notification bubble, without laying it out.
+ * 
+ * @details Used to claim a place in the stack before the toolkit has started.
+ *          The text is measured from its length, and the icon from the header
+ *          of its file, which is much cheaper than decoding it.
+ * 
+ * @param[in]  s      The settings of the bubble.
+ * @param[out] width  The estimated width.
+ * @param[out] height The estimated height.
+ */
+void render::estimate(const struct settings& s, int& width, int& height)
+{
+    int titlew = 0;
+    int titleh = 0;
+    int bodyw  = 0;
+    int bodyh  = 0;
+    int iconw  = 0;
+    int iconh  = 0;
+    int gap    = 0;
+    estimate_text(s, s.title, s.titlesize, titlew, titleh);
+    estimate_text(s, s.body, s.bodysize, bodyw, bodyh);
+    if (!s.icon.empty()
+        && gdk_pixbuf_get_file_info(s.icon.c_str(), &iconw, &iconh))
+    {
+        gap = s.spacing;
+    }
+
+    if (s.progress >= 0)
+    {
+        bodyw  = 0;
+        bodyh  = std::min(bodyh, (int) std::lround(s.bodysize*96.0/72.0*1.25));
+        titlew = std::max(titlew, kBarWidth);
+        bodyh += kBarSpacing + kBarHeight;
+    }
+
+    width  = s.margin[3] + iconw + gap + std::max(titlew, bodyw) + s.margin[1]
+        + s.curve;
+    height = s.margin[0] + std::max(iconh, titleh + bodyh) + s.margin[2]
+        + s.curve;
+    if (s.width > 0)
+    {
+        width = s.width;
+    }
+    if (s.height > 0)
+    {
+        height = s.height;
+    }
+}
+
+/**
+ * @brief Draw a notification bubble.
+ * 
+ * @details The background is the same rounded rectangle that
+ *          notification::on_draw() draws, with the icon and text drawn on top
+ *          of it.
+ * 
+ * @param[in] cr The Cairo context to draw with.
+ * @param[in] s  The settings of the bubble.
+ * @param[in] l  The layout of the bubble.
+ */
+void render::draw(cairo_t* cr, const struct settings& s,
+                  const struct layout& l)
+{
+    double width  = l.width;
+    double height = l.height;
+    double curve  = s.curve;
+    double deg    = M_PI / 180.0;
+    cairo_save(cr);
+    cairo_new_path(cr);
+    cairo_arc(cr, width-curve, curve,        curve, -90*deg,   0*deg);
+    cairo_arc(cr, width-curve, height-curve, curve,   0*deg,  90*deg);
+    cairo_arc(cr, curve,       height-curve, curve,  90*deg, 180*deg);
+    cairo_arc(cr, curve,       curve,        curve, 180*deg, 270*deg);
+    cairo_close_path(cr);
+    gdk_cairo_set_source_rgba(cr, &s.background);
+    cairo_fill(cr);
+
+    if (l.icon)
+    {
+        gdk_cairo_set_source_pixbuf(cr, l.icon, l.iconx, l.icony);
+        cairo_paint(cr);
+    }
+
+    gdk_cairo_set_source_rgba(cr, &s.foreground);
+    if (l.title)
+    {
+        cairo_move_to(cr, l.textx, l.texty);
+        pango_cairo_update_layout(cr, l.title);
+        pango_cairo_show_layout(cr, l.title);
+    }
+    if (l.body)
+    {
+        cairo_move_to(cr, l.textx, l.texty+l.titleh);
+        pango_cairo_update_layout(cr, l.body);
+        pango_cairo_show_layout(cr, l.body);
+    }
+    cairo_restore(cr);
+    if (l.barw > 0)
+    {
+        render::draw_bar(cr, l.barx, l.bary, l.barw, kBarHeight, s.progress,
+                         s.foreground);
+    }
+    render::draw_badge(cr, s.count, l.width, s.curve);
+}
+
+/**
+ * @brief Draw the repeat counter of a notification bubble in its top right
+ *        corner.
+ * 
+ * @details The counter is drawn over the bubble, inside the padding that the
+ *          curvature adds, so that the bubble does not have to be laid out or
+ *          resized again when the count changes. Nothing is drawn for a
+ *          notification that was only sent once.
+ * 
+ * @param[in] cr    The Cairo context to draw with.
+ * @param[in] count Number of times the bubble was sent.
+ * @param[in] width Width of the bubble.
+ * @param[in] curve Curvature of the corners of the bubble.
+ */
+void render::draw_badge(cairo_t* cr, long count, int width, int curve)
+{
+    if (count < 2)
+    {
+        return;
+    }
+    std::string text = "\u00d7" + std::to_string(count);
+    PangoLayout* layout = pango_cairo_create_layout(cr);
+    PangoFontDescription* desc = pango_font_description_from_string(
+        "Sans Bold 8");
+    pango_layout_set_font_description(layout, desc);
+    pango_font_description_free(desc);
+    pango_layout_set_text(layout, text.c_str(), -1);
+
+    int tw;
+    int th;
+    pango_layout_get_pixel_size(layout, &tw, &th);
+    double inset = std::max(curve / 4.0, 3.0);
+    double h = th + 2;
+    double w = std::max(tw + h, h);
+    double x = width - w - inset;
+    double y = inset;
+    cairo_save(cr);
+    cairo_new_path(cr);
+    cairo_arc(cr, x+w-h/2, y+h/2, h/2, -M_PI/2, M_PI/2);
+    cairo_arc(cr, x+h/2,   y+h/2, h/2,  M_PI/2, 3*M_PI/2);
+    cairo_close_path(cr);
+    cairo_set_source_rgba(cr, 0, 0, 0, 0.4);
+    cairo_fill(cr);
+    cairo_set_source_rgb(cr, 1, 1, 1);
+    cairo_move_to(cr, x + (w-tw)/2, y + 1);
+    pango_cairo_show_layout(cr, layout);
+    cairo_restore(cr);
+    g_object_unref(layout);
+}
+
+/**
+ * @brief Draw a progress bar.
+ * 
+ * @details The bar is a rounded track in a faint shade of the color, filled
+ *          from the left in the color itself. It is drawn on its own, so that
+ *          an update only has to redraw the area of the bar.
+ * 
+ * @param[in] cr       The Cairo context to draw with.
+ * @param[in] x        X-position of the bar.
+ * @param[in] y        Y-position of the bar.
+ * @param[in] width    Width of the bar.
+ * @param[in] height   Height of the bar.
+ * @param[in] fraction Fraction of the bar that is filled, from 0 to 1.
+ * @param[in] color    Color of the bar.
+ */
+void render::draw_bar(cairo_t* cr, double x, double y, double width,
+                      double height, double fraction, const GdkRGBA& color)
+{
+    double r = height / 2;
+    double filled = std::min(std::max(fraction, 0.0), 1.0) * width;
+    cairo_save(cr);
+    cairo_new_path(cr);
+    cairo_arc(cr, x+width-r, y+r, r, -M_PI/2, M_PI/2);
+    cairo_arc(cr, x+r,       y+r, r,  M_PI/2, 3*M_PI/2);
+    cairo_close_path(cr);
+    cairo_set_source_rgba(cr, color.red, color.green, color.blue,
+                          color.alpha*0.3);
+    cairo_fill_preserve(cr);
+    cairo_clip(cr);
+    cairo_rectangle(cr, x, y, filled, height);
+    gdk_cairo_set_source_rgba(cr, &color);
+    cairo_fill(cr);
+    cairo_restore(cr);
+}
+
+/**
+ * @brief Release the resources held by a layout.
+ * 
+ * @param[in,out] l The layout.
+ */
+void render::release(struct layout& l)
+{
+    if (l.title)
+    {
+        g_object_unref(l.title);
+    }
+    if (l.body)
+    {
+        g_object_unref(l.body);
+    }
+    if (l.icon)
+    {
+        g_object_unref(l.icon);
+    }
+    l = {};
+}
+
+/**
+ * @brief Render a notification bubble to a PNG file, and print the layout and
+ *        draw timings to stderr.
+ * 
+ * @details The bubble is laid out against a scratch image surface, to find its
+ *          size, and then drawn onto an image surface of that size. Nothing
+ *          here needs a display, so this can be used to profile, or compare
+ *          the output of, the rendering on a machine without one.
+ * 
+ * @param[in] cli  The command line interface.
+ * @param[in] path Path of the PNG file.
+ * 
+ * @return 0 on success. Any other value is an error, using the same values as
+ *         notification::build(), or 9 if the file could not be written.
+ */
+int render::to_png(commandline::interface& cli, const std::string& path)
+{
+    struct settings s;
+    struct layout l;
+    cairo_surface_t* surface;
+    cairo_t* cr;
+    cairo_status_t written;
+    double start;
+    double layouttime;
+    double drawtime;
+    int status;
+
+    if ((status=render::resolve(cli, s)) != 0)
+    {
+        return status;
+    }
+
+    surface = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, 1, 1);
+    cr = cairo_create(surface);
+    start = util::now();
+    status = render::lay_out(cr, s, l);
+    layouttime = util::now() - start;
+    cairo_destroy(cr);
+    cairo_surface_destroy(surface);
+    if (status != 0)
+    {
+        render::release(l);
+        return 2;
+    }
+
+    surface = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, l.width,
+                                         l.height);
+    cr = cairo_create(surface);
+    start = util::now();
+    render::draw(cr, s, l);
+    cairo_surface_flush(surface);
+    drawtime = util::now() - start;
+    written = cairo_surface_write_to_png(surface, path.c_str());
+    cairo_destroy(cr);
+    cairo_surface_destroy(surface);
+
+    fprintf(stderr, "%s: Size: (%d, %d)\n", PROGRAM, l.width, l.height);
+    fprintf(stderr, "%s: Layout: %.3f ms\n", PROGRAM, layouttime);
+    fprintf(stderr, "%s: Draw: %.3f ms\n", PROGRAM, drawtime);
+    render::release(l);
+    if (written != CAIRO_STATUS_SUCCESS)
+    {
+        fprintf(stderr, "%s: Unable to write '%s': %s.\n", PROGRAM,
+                path.c_str(), cairo_status_to_string(written));
+        return 9;
+    }
+    return 0;
+}
+
+ARIA_NAMESPACE_END
@@ -26,63 +26,1227 @@
 #include <cstdlib>
 #include <cerrno>
 #include <cstring>
+#include <string>
 #include <stdio.h>
 #include <sys/file.h>
+#include <sched.h>
+#include <signal.h>
+#include <time.h>
+#include <climits>
+#include <linux/futex.h>
+#include <sys/syscall.h>
 
 /* Declares */
-static const  char   *MFILE   = "/tmp/ariamap";
+static const  int     BKEYBITS = 24;
+static const  int     BTIMEBITS = 64 - BKEYBITS;
+static const  unsigned long BTIMEMASK = (1UL << BTIMEBITS) - 1;
 static const  int     MPROT   = PROT_READ | PROT_WRITE;
 static const  int     MFLAGS  = MAP_SHARED;
 static const  size_t  MLEN    = 2*10;
 static const  size_t  MSIZE   = MLEN * sizeof(struct SharedMemType);
+static const  size_t  MOFFSET = sizeof(struct SharedMemHeader);
+static const  size_t  MTOTAL  = MOFFSET + SHAREDMEM_MONITORS*MSIZE;
+static const  unsigned long MMAGIC = 0x4152494100000AUL;
+static        long    MPART   = 0;
+static        long    MRESERVED = -1;
+static        long    MSELF   = 0;
 static        long   *MADDR   = NULL;
-static const  mode_t  FMODE   = 0777;
-static        int     FFLAGS  = O_RDWR;
+static struct SharedMemHeader *HADDR = NULL;
+static const  mode_t  FMODE   = 0600;
+static        int     FFLAGS  = O_RDWR | O_NOFOLLOW | O_CLOEXEC;
 static        int     FD      = -1;
 static struct SharedMemType MEM[MLEN];
 
+/* ************************************************************************** */
+/**
+ * @brief Path to the file that holds the shared memory region.
+ * 
+ * @details The file is kept in $XDG_RUNTIME_DIR, which is private to the user,
+ *          or in /tmp, with the user ID in its name, if that is not set. The
+ *          region decides which processes are signalled, and what text and
+ *          icon they show, so it is never shared with other users.
+ */
+const char * AriaSharedMem::mempath(void)
+{
+    static const char *dir = getenv("XDG_RUNTIME_DIR");
+    static const std::string path = ( (dir != NULL) && (dir[0] != '\0') )
+        ? std::string(dir) + "/" + PROGRAM + "-map"
+        : std::string("/tmp/") + PROGRAM + "-map-" + std::to_string(getuid());
+    return path.c_str();
+}
+
+/* ************************************************************************** */
+/**
+ * @brief Open the file that holds the shared memory region.
+ * 
+ * @details A symbolic link is not followed, and a file that belongs to another
+ *          user, e.g. one made in /tmp ahead of time, is not used.
+ * 
+ * @param flags flags to open the file with, on top of FFLAGS.
+ */
+int AriaSharedMem::fileopen(int flags)
+{
+    struct stat statbuf;
+    int fd;
+    if ( (fd=open(AriaSharedMem::mempath(), FFLAGS | flags, FMODE)) < 0 )
+        return -1;
+    if ( (fstat(fd, &statbuf) < 0) || (statbuf.st_uid != getuid()) ) {
+        close(fd);
+        errno = EACCES;
+        return -1;
+    }
+
+    return fd;
+}
+
+/* ************************************************************************** */
+/**
+ * @brief Map the header of the shared memory region.
+ * 
+ * @details The header stays mapped for the lifetime of the process, so that it
+ *          can be read without taking the lock. The first process to map it
+ *          creates the file, only readable by the user, grows it to its full
+ *          size, and initializes it.
+ *          A region with a different layout, e.g. from an older version, is
+ *          cleared.
+ */
+struct SharedMemHeader * AriaSharedMem::header(void)
+{
+    if ( HADDR != NULL )
+        return HADDR;
+
+    struct stat statbuf;
+    void *addr;
+    int fd;
+    if ( (fd=AriaSharedMem::fileopen(O_CREAT)) < 0 )
+        return NULL;
+    if ( (fstat(fd, &statbuf) < 0)
+         || (((size_t)statbuf.st_size < MTOTAL) && (ftruncate(fd, MTOTAL) < 0)) ) {
+        close(fd);
+        return NULL;
+    }
+
+    addr = mmap(NULL, MTOTAL, MPROT, MFLAGS, fd, 0);
+    if ( addr == MAP_FAILED ) {
+        close(fd);
+        return NULL;
+    }
+
+    struct SharedMemHeader *hdr = (struct SharedMemHeader *) addr;
+    if ( __atomic_load_n(&hdr->magic, __ATOMIC_ACQUIRE) != MMAGIC ) {
+        flock(fd, LOCK_EX);
+        if ( hdr->magic != MMAGIC ) {
+            memset(addr, 0, MTOTAL);
+            __atomic_store_n(&hdr->magic, MMAGIC, __ATOMIC_RELEASE);
+        }
+        flock(fd, LOCK_UN);
+    }
+    close(fd);
+
+    HADDR = hdr;
+    return HADDR;
+}
+
+/* ************************************************************************** */
+/**
+ * @brief Read the screen geometry from the header, without taking the lock.
+ * 
+ * @details Copy the geometry, and retry if the sequence counter shows that it
+ *          was being written during the copy.
+ * 
+ * @param g the geometry that was read.
+ */
+int AriaSharedMem::getgeometry(struct SharedMemGeometry *g)
+{
+    struct SharedMemHeader *hdr = AriaSharedMem::header();
+    unsigned long seq;
+    int tries;
+    if ( hdr == NULL )
+        return -1;
+
+    for ( tries = 0; tries < 100; ++tries ) {
+        seq = __atomic_load_n(&hdr->sequence, __ATOMIC_ACQUIRE);
+        if ( seq & 1 ) {
+            sched_yield();
+            continue;
+        }
+        memcpy(g, &hdr->geometry, sizeof(*g));
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        if ( seq == __atomic_load_n(&hdr->sequence, __ATOMIC_RELAXED) )
+            return (g->nmonitors > 0) ? 0 : -1;
+    }
+    return -1;
+}
+
+/* ************************************************************************** */
+/**
+ * @brief Write the screen geometry to the header, without taking the lock.
+ * 
+ * @details Only one process writes at a time. If another process is already
+ *          writing, or has written geometry with a newer RandR configuration
+ *          timestamp, nothing is written.
+ * 
+ * @param g the geometry to write.
+ */
+int AriaSharedMem::setgeometry(struct SharedMemGeometry *g)
+{
+    struct SharedMemHeader *hdr = AriaSharedMem::header();
+    unsigned long seq;
+    if ( hdr == NULL )
+        return -1;
+
+    seq = __atomic_load_n(&hdr->sequence, __ATOMIC_ACQUIRE);
+    if ( (seq & 1)
+         || !__atomic_compare_exchange_n(&hdr->sequence, &seq, seq+1, false,
+                                         __ATOMIC_ACQUIRE, __ATOMIC_RELAXED) )
+        return -1;
+
+    int status = -1;
+    if ( (hdr->geometry.nmonitors == 0)
+         || (g->timestamp >= hdr->geometry.timestamp) ) {
+        __atomic_thread_fence(__ATOMIC_RELEASE);
+        memcpy(&hdr->geometry, g, sizeof(*g));
+        status = 0;
+    }
+    __atomic_store_n(&hdr->sequence, seq+2, __ATOMIC_RELEASE);
+    return status;
+}
+
+/* ************************************************************************** */
+/**
+ * @brief Take a token from a rate limiting bucket in the header, without
+ *        taking the lock.
+ * 
+ * @details A bucket is kept as the time, in milliseconds of the monotonic
+ *          clock, at which it will be full again, so that it fits in one word
+ *          along with its key, and can be updated with a single compare and
+ *          swap. A token can be taken as long as that time is no more than a
+ *          full bucket ahead of now. Each token taken pushes it forward by
+ *          one interval.
+ * 
+ *          Key 0 is the bucket shared by all notifications. Any other key is
+ *          looked up in the rest of the buckets, starting from its hash, and
+ *          takes over a bucket that is full when it is not found. If every
+ *          bucket it could use is busy, the token is given.
+ * 
+ * @param key identifies the bucket, or 0 for the shared one.
+ * 
+ * @param interval milliseconds for one token to be put back in the bucket.
+ * 
+ * @param burst number of tokens that a full bucket holds.
+ * 
+ * @return 0 if a token was taken, 1 if the bucket is empty, and -1 if the
+ *         header can not be mapped.
+ */
+int AriaSharedMem::take(unsigned long key, long interval, long burst)
+{
+    struct SharedMemHeader *hdr = AriaSharedMem::header();
+    struct timespec ts;
+    unsigned long *bucket = NULL;
+    unsigned long old = 0;
+    unsigned long val;
+    unsigned long now;
+    unsigned long full;
+    unsigned long tag;
+    size_t i;
+    size_t slot;
+    if ( hdr == NULL )
+        return -1;
+    if ( (interval <= 0) || (burst <= 0) )
+        return 0;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    now = ((unsigned long)ts.tv_sec*1000 + ts.tv_nsec/1000000) & BTIMEMASK;
+    tag = (key == 0) ? 0 : (key % ((1UL << BKEYBITS) - 1)) + 1;
+
+    while ( true ) {
+        if ( tag == 0 ) {
+            bucket = &hdr->buckets[0];
+            old    = __atomic_load_n(bucket, __ATOMIC_ACQUIRE);
+        }
+        else {
+            bucket = NULL;
+            for ( i = 0; i < SHAREDMEM_BUCKETS-1; ++i ) {
+                slot = 1 + (key + i) % (SHAREDMEM_BUCKETS-1);
+                val  = __atomic_load_n(&hdr->buckets[slot], __ATOMIC_ACQUIRE);
+                if ( (val >> BTIMEBITS) == tag ) {
+                    bucket = &hdr->buckets[slot];
+                    old    = val;
+                    break;
+                }
+                if ( (bucket == NULL) && ((val & BTIMEMASK) <= now) ) {
+                    bucket = &hdr->buckets[slot];
+                    old    = val;
+                }
+            }
+            if ( bucket == NULL )
+                return 0;
+        }
+
+        /* A bucket of another key is taken over as full, as is one that is
+           further ahead than possible, e.g. from before a reboot */
+        full = old & BTIMEMASK;
+        if ( ((old >> BTIMEBITS) != tag)
+             || (full > now + (unsigned long)(interval*burst)) )
+            full = now;
+        if ( full < now )
+            full = now;
+        if ( full + interval > now + (unsigned long)(interval*burst) )
+            return 1;
+
+        val = (tag << BTIMEBITS) | ((full + interval) & BTIMEMASK);
+        if ( __atomic_compare_exchange_n(bucket, &old, val, false,
+                                         __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE) )
+            return 0;
+    }
+}
+
+/* ************************************************************************** */
+/**
+ * @brief Select the table of the monitor to operate on.
+ * 
+ * @details The table can not be changed while the shared memory region is
+ *          open. Monitors past the number of tables share the last one.
+ * 
+ * @param monitor index of the monitor.
+ */
+int AriaSharedMem::select(long monitor)
+{
+    if ( FD >= 0 )
+        return -1;
+
+    if ( monitor < 0 )
+        monitor = 0;
+    if ( monitor >= SHAREDMEM_MONITORS )
+        monitor = SHAREDMEM_MONITORS-1;
+    MPART = monitor;
+
+    return 0;
+}
+
 /* ************************************************************************** */
 /**
  * @brief Interface to save information in shared memory.
  * 
  * @details Executes the whole process of mapping the shared memory region,
- *          storing the data, unmapping, and cleanup.
+ *          storing the data, unmapping, and cleanup. The data is stored in
+ *          the table of the monitor that it is on. If a less urgent
+ *          notification had to make way for it, the others are told to move.
  * 
- * @param data information to save in shared memory.
+ * @param data information to save in shared memory. On return, holds the
+ *        position that was assigned.
  * 
  * @param shift number of pixels to separate elements that overlap.
  */
 int AriaSharedMem::add(struct SharedMemType *data, long shift)
 {
     int status;
+    int moved;
+    if ( (status=AriaSharedMem::select(data->monitor)) < 0 )
+        return status;
     if ( (status=AriaSharedMem::memopen()) < 0 )
         return -1;
-    if ( (status=AriaSharedMem::update()) < 0 )
+    AriaSharedMem::update();
+    moved = AriaSharedMem::place(data, shift);
+    if ( (status=AriaSharedMem::memclose()) < 0 )
         return status;
-    if ( (status=AriaSharedMem::displace(data, shift)) < 0 )
+    if ( moved > 0 )
+        AriaSharedMem::notify();
+
+    return (moved < 0) ? -1 : 0;
+}
+
+/* ************************************************************************** */
+/**
+ * @brief Claim a place in the stack before the real size is known.
+ * 
+ * @details The data holds an estimated size. Claiming the place early means
+ *          that notifications started at the same time see each other, and
+ *          commit() only has to move the others if the estimate was wrong.
+ *          A place that was already claimed with claim() is filled in.
+ * 
+ * @param data information to save in shared memory, with an estimated size.
+ * 
+ * @param shift number of pixels to separate elements that overlap.
+ */
+int AriaSharedMem::reserve(struct SharedMemType *data, long shift)
+{
+    int status;
+    if ( MRESERVED >= 0 )
+        status = AriaSharedMem::commit(data, shift);
+    else
+        status = AriaSharedMem::add(data, shift);
+    if ( status < 0 )
         return status;
-    if ( (status=AriaSharedMem::append(data)) < 0 )
+    MRESERVED = MPART;
+
+    return 0;
+}
+
+/* ************************************************************************** */
+/**
+ * @brief Set the real position and size of the notification in its stack.
+ * 
+ * @details If a place was reserved in the same table, it is updated in place,
+ *          keeping its order in the stack, and the stack is only reflowed if
+ *          the position or size differs from the estimate. The other
+ *          notifications are only told to move if one of them did. A place
+ *          reserved on another monitor is given up first. Without a
+ *          reservation, this is the same as add().
+ * 
+ * @param data information to save in shared memory. On return, holds the
+ *        position that was assigned.
+ * 
+ * @param shift number of pixels to separate elements that overlap.
+ */
+int AriaSharedMem::commit(struct SharedMemType *data, long shift)
+{
+    struct SharedMemType old[MLEN];
+    struct SharedMemType *entry;
+    size_t i;
+    int status;
+    int index;
+    int moved = 0;
+    if ( (MRESERVED >= 0) && (MRESERVED != data->monitor) )
+        AriaSharedMem::cancel(shift);
+    MRESERVED = -1;
+    if ( (status=AriaSharedMem::select(data->monitor)) < 0 )
         return status;
+    if ( (status=AriaSharedMem::memopen()) < 0 )
+        return -1;
+    AriaSharedMem::update();
+    if ( (index=AriaSharedMem::findcurrent()) < 0 ) {
+        status = AriaSharedMem::place(data, shift);
+        AriaSharedMem::memclose();
+        if ( status > 0 )
+            AriaSharedMem::notify();
+        return (status < 0) ? -1 : 0;
+    }
+
+    entry = &MEM[index];
+    if ( (entry->x == data->x) && (entry->home == data->y)
+         && (entry->w == data->w) && (entry->h == data->h)
+         && (entry->gravity == data->gravity)
+         && (entry->urgency == data->urgency) ) {
+        *data = *entry;
+        return AriaSharedMem::memclose();
+    }
+
+    entry->time    = data->time;
+    entry->hash    = data->hash;
+    entry->tag     = data->tag;
+    entry->x       = data->x;
+    entry->home    = data->y;
+    entry->w       = data->w;
+    entry->h       = data->h;
+    entry->gravity = data->gravity;
+    entry->urgency = data->urgency;
+    memcpy(old, MEM, MSIZE);
+    AriaSharedMem::reflow(shift);
+    for ( i = 0; i < MLEN; ++i ) {
+        if ( old[i].id == 0 )
+            break;
+        if ( ((int)i != index) && (old[i].y != MEM[i].y) )
+            moved = 1;
+    }
+    *data = MEM[index];
     if ( (status=AriaSharedMem::memclose()) < 0 )
         return status;
+    if ( moved )
+        AriaSharedMem::notify();
 
     return 0;
 }
 
+/* ************************************************************************** */
+/**
+ * @brief Give up a place that was reserved, but never committed.
+ * 
+ * @param shift number of pixels to separate elements that overlap.
+ */
+int AriaSharedMem::cancel(long shift)
+{
+    if ( MRESERVED < 0 )
+        return 0;
+    if ( AriaSharedMem::select(MRESERVED) < 0 )
+        return -1;
+    MRESERVED = -1;
+
+    return AriaSharedMem::remove(shift);
+}
+
 /* ************************************************************************** */
 /**
  * @brief Cleanup shared memory that is no longer being used.
  * 
  * @details Cleanup shared memory that is no longer being used and reorder the
- *          shared memory region so that used memory is at the start.
+ *          shared memory region so that used memory is at the start. The
+ *          remaining notifications are then stacked again, closing the gap,
+ *          and told to move to their new positions. This operates on the
+ *          table of the monitor that was last selected.
+ * 
+ * @param shift number of pixels to separate elements that overlap.
  */
-int AriaSharedMem::remove(void)
+int AriaSharedMem::remove(long shift)
 {
     AriaSharedMem::memopen();
     AriaSharedMem::update();
     AriaSharedMem::clearcurrent();
     AriaSharedMem::reorder();
+    AriaSharedMem::reflow(shift);
     AriaSharedMem::memclose();
+    AriaSharedMem::notify();
+    AriaSharedMem::wake();
+
+    return 0;
+}
+
+/* ************************************************************************** */
+/**
+ * @brief Retrieve the current entry of a notification.
+ * 
+ * @details Used by a notification that was told its position may have
+ *          changed, to find out where it should now be.
+ * 
+ * @param monitor index of the monitor the notification is on.
+ * 
+ * @param id the ID of the notification.
+ * 
+ * @param data the entry that was found.
+ */
+int AriaSharedMem::lookup(long monitor, long id, struct SharedMemType *data)
+{
+    int status;
+    int index;
+    if ( (status=AriaSharedMem::select(monitor)) < 0 )
+        return status;
+    if ( (status=AriaSharedMem::memopen()) < 0 )
+        return -1;
+    AriaSharedMem::update();
+    if ( (index=AriaSharedMem::find(id)) >= 0 )
+        *data = MEM[index];
+    AriaSharedMem::memclose();
+
+    return (index < 0) ? -1 : 0;
+}
+
+/* ************************************************************************** */
+/**
+ * @brief Hand a notification to a notification on screen with the same title
+ *        and body.
+ * 
+ * @details The tables are first scanned through the header mapping, without
+ *          taking any lock, so that a notification with no duplicate does not
+ *          wait on any of them. A match is then checked again under the lock
+ *          of its table, its count is bumped, and it is sent SIGUSR2 to show
+ *          the new count and restart its timeout.
+ * 
+ * @param hash hash of the title and body of the notification.
+ * 
+ * @param window number of seconds since a notification was last sent, within
+ *        which it is still coalesced.
+ * 
+ * @return 0 if the notification was handed over, and -1 otherwise.
+ */
+int AriaSharedMem::coalesce(unsigned long hash, long window)
+{
+    struct SharedMemHeader *hdr = AriaSharedMem::header();
+    struct SharedMemType *table;
+    long pid = AriaSharedMem::self();
+    long now = time(0);
+    long id = 0;
+    long monitor = 0;
+    long m;
+    size_t i;
+    int index;
+    if ( (hdr == NULL) || (hash == 0) )
+        return -1;
+
+    for ( m = 0; (m < SHAREDMEM_MONITORS) && (id == 0); ++m ) {
+        table = (struct SharedMemType *) ((char *) hdr + MOFFSET + m*MSIZE);
+        for ( i = 0; i < MLEN; ++i ) {
+            if ( table[i].id == 0 )
+                break;
+            if ( (table[i].hash == hash) && (table[i].id != pid)
+                 && (now - table[i].time <= window) ) {
+                id      = table[i].id;
+                monitor = m;
+                break;
+            }
+        }
+    }
+    if ( (id == 0) || (AriaSharedMem::signal(id, 0) < 0) )
+        return -1;
+
+    if ( (AriaSharedMem::select(monitor) < 0)
+         || (AriaSharedMem::memopen() < 0) )
+        return -1;
+    AriaSharedMem::update();
+    index = AriaSharedMem::find(id);
+    if ( (index >= 0) && (MEM[index].hash == hash) ) {
+        MEM[index].count += 1;
+        MEM[index].time   = now;
+    }
+    AriaSharedMem::memclose();
+    if ( (index < 0) || (MEM[index].hash != hash) )
+        return -1;
+
+    return AriaSharedMem::signal(id, SIGUSR2) < 0 ? -1 : 0;
+}
+
+/* ************************************************************************** */
+/**
+ * @brief Hand new contents to the notification on screen with the same tag.
+ * 
+ * @details The tables are scanned through the header mapping, without taking
+ *          any lock, for a notification with the tag. The contents are then
+ *          written to the mailbox of the tag, or to a mailbox that is free or
+ *          whose notification has exited, and the notification is sent
+ *          SIGUSR2 to read them.
+ * 
+ * @param p the new contents, with the tag and fields set.
+ * 
+ * @return 0 if the contents were handed over, and -1 otherwise.
+ */
+int AriaSharedMem::deliver(struct SharedMemPayload *p)
+{
+    struct SharedMemHeader *hdr = AriaSharedMem::header();
+    struct SharedMemPayload *box = NULL;
+    struct SharedMemPayload *mb;
+    struct SharedMemType *table;
+    unsigned long seq;
+    long id = 0;
+    long m;
+    size_t i;
+    int tries;
+    if ( (hdr == NULL) || (p->tag == 0) )
+        return -1;
+
+    for ( m = 0; (m < SHAREDMEM_MONITORS) && (id == 0); ++m ) {
+        table = (struct SharedMemType *) ((char *) hdr + MOFFSET + m*MSIZE);
+        for ( i = 0; i < MLEN; ++i ) {
+            if ( table[i].id == 0 )
+                break;
+            if ( (table[i].tag == p->tag)
+                 && (table[i].id != AriaSharedMem::self()) ) {
+                id = table[i].id;
+                break;
+            }
+        }
+    }
+    if ( (id == 0) || (AriaSharedMem::signal(id, 0) < 0) )
+        return -1;
+
+    for ( i = 0; i < SHAREDMEM_MAILBOXES; ++i ) {
+        mb = &hdr->mailboxes[(p->tag + i) % SHAREDMEM_MAILBOXES];
+        if ( (mb->tag == p->tag) && (mb->id == id) ) {
+            box = mb;
+            break;
+        }
+        if ( (box == NULL)
+             && ((mb->id == 0)
+                 || ((AriaSharedMem::signal(mb->id, 0) < 0)
+                     && (errno == ESRCH))) )
+            box = mb;
+    }
+    if ( box == NULL )
+        return -1;
+
+    for ( tries = 0; tries < 100; ++tries ) {
+        seq = __atomic_load_n(&box->sequence, __ATOMIC_ACQUIRE);
+        if ( !(seq & 1)
+             && __atomic_compare_exchange_n(&box->sequence, &seq, seq+1, false,
+                                            __ATOMIC_ACQUIRE, __ATOMIC_RELAXED) )
+            break;
+        sched_yield();
+    }
+    if ( tries == 100 )
+        return -1;
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    box->tag    = p->tag;
+    box->id     = id;
+    box->fields = p->fields;
+    memcpy(box->title, p->title, sizeof(box->title));
+    memcpy(box->body,  p->body,  sizeof(box->body));
+    memcpy(box->icon,  p->icon,  sizeof(box->icon));
+    __atomic_store_n(&box->sequence, seq+2, __ATOMIC_RELEASE);
+
+    return AriaSharedMem::signal(id, SIGUSR2) < 0 ? -1 : 0;
+}
+
+/* ************************************************************************** */
+/**
+ * @brief Read new contents that were handed to this notification.
+ * 
+ * @details Copy the mailbox of the tag, and retry if the sequence counter
+ *          shows that it was being written during the copy.
+ * 
+ * @param tag hash of the tag of this notification.
+ * 
+ * @param seen sequence counter of the contents that were last read. Updated
+ *        when new contents are read.
+ * 
+ * @param p the new contents.
+ * 
+ * @return 0 if there were new contents, and -1 otherwise.
+ */
+int AriaSharedMem::collect(unsigned long tag, unsigned long *seen,
+                           struct SharedMemPayload *p)
+{
+    struct SharedMemHeader *hdr = AriaSharedMem::header();
+    struct SharedMemPayload *mb;
+    unsigned long seq;
+    long pid = AriaSharedMem::self();
+    size_t i;
+    int tries;
+    if ( (hdr == NULL) || (tag == 0) )
+        return -1;
+
+    for ( i = 0; i < SHAREDMEM_MAILBOXES; ++i ) {
+        mb = &hdr->mailboxes[(tag + i) % SHAREDMEM_MAILBOXES];
+        if ( (mb->tag != tag) || (mb->id != pid) )
+            continue;
+        for ( tries = 0; tries < 100; ++tries ) {
+            seq = __atomic_load_n(&mb->sequence, __ATOMIC_ACQUIRE);
+            if ( seq & 1 ) {
+                sched_yield();
+                continue;
+            }
+            if ( seq == *seen )
+                return -1;
+            memcpy(p, mb, sizeof(*p));
+            __atomic_thread_fence(__ATOMIC_ACQUIRE);
+            if ( seq == __atomic_load_n(&mb->sequence, __ATOMIC_RELAXED) ) {
+                p->title[sizeof(p->title)-1] = '\0';
+                p->body[sizeof(p->body)-1]   = '\0';
+                p->icon[sizeof(p->icon)-1]   = '\0';
+                *seen = seq;
+                return 0;
+            }
+        }
+        return -1;
+    }
+
+    return -1;
+}
+
+/* ************************************************************************** */
+/**
+ * @brief Fold a notification into the summary notification of a monitor, if
+ *        too many notifications are visible on it.
+ * 
+ * @details The visible notifications are counted under the lock of the table,
+ *          leaving out the summary notification itself. The title is added to
+ *          the recent titles of the summary. If the summary notification has
+ *          exited, or there is none, this process is elected to display it,
+ *          and the summary starts over. Otherwise, the summary notification
+ *          is sent SIGUSR2 to read it.
+ * 
+ * @param monitor index of the monitor.
+ * 
+ * @param limit maximum number of notifications that are visible, besides the
+ *        summary notification.
+ * 
+ * @param title title of the notification.
+ * 
+ * @return 1 if the notification was folded into the summary notification of
+ *         another process, 0 if this process was elected to display the
+ *         summary, and -1 if the notification should be displayed on its own.
+ */
+int AriaSharedMem::fold(long monitor, long limit, const char *title)
+{
+    struct SharedMemHeader *hdr = AriaSharedMem::header();
+    struct SharedMemSummary *s;
+    unsigned long seq;
+    long owner;
+    long count = 0;
+    size_t i;
+    if ( (hdr == NULL) || (limit <= 0) )
+        return -1;
+    if ( (AriaSharedMem::select(monitor) < 0)
+         || (AriaSharedMem::memopen() < 0) )
+        return -1;
+    s = &hdr->summaries[MPART];
+    AriaSharedMem::update();
+    for ( i = 0; i < MLEN; ++i ) {
+        if ( MEM[i].id == 0 )
+            break;
+        if ( MEM[i].id != s->owner )
+            ++count;
+    }
+    if ( count < limit ) {
+        AriaSharedMem::memclose();
+        return -1;
+    }
+
+    seq = __atomic_load_n(&s->sequence, __ATOMIC_RELAXED);
+    __atomic_store_n(&s->sequence, seq+1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    owner = s->owner;
+    if ( (owner == 0) || (AriaSharedMem::signal(owner, 0) < 0) ) {
+        memset((char *) s + sizeof(s->sequence), 0,
+               sizeof(*s) - sizeof(s->sequence));
+        s->owner = AriaSharedMem::self();
+    }
+    strncpy(s->titles[s->next], title, sizeof(s->titles[0])-1);
+    s->titles[s->next][sizeof(s->titles[0])-1] = '\0';
+    s->next   = (s->next + 1) % SHAREDMEM_SUMMARY;
+    s->count += 1;
+    __atomic_store_n(&s->sequence, seq+2, __ATOMIC_RELEASE);
+    owner = s->owner;
+    AriaSharedMem::memclose();
+
+    if ( owner == AriaSharedMem::self() )
+        return 0;
+    return AriaSharedMem::signal(owner, SIGUSR2) < 0 ? -1 : 1;
+}
+
+/* ************************************************************************** */
+/**
+ * @brief Read the summary of a monitor, for its summary notification.
+ * 
+ * @details Copy the summary, and retry if the sequence counter shows that it
+ *          was being written during the copy.
+ * 
+ * @param monitor index of the monitor.
+ * 
+ * @param seen sequence counter of the summary that was last read. Updated
+ *        when a new summary is read.
+ * 
+ * @param s the summary.
+ * 
+ * @return 0 if there was a new summary, and -1 otherwise.
+ */
+int AriaSharedMem::summary(long monitor, unsigned long *seen,
+                           struct SharedMemSummary *s)
+{
+    struct SharedMemHeader *hdr = AriaSharedMem::header();
+    struct SharedMemSummary *src;
+    unsigned long seq;
+    int tries;
+    if ( (hdr == NULL) || (monitor < 0) )
+        return -1;
+    if ( monitor >= SHAREDMEM_MONITORS )
+        monitor = SHAREDMEM_MONITORS-1;
+
+    src = &hdr->summaries[monitor];
+    for ( tries = 0; tries < 100; ++tries ) {
+        seq = __atomic_load_n(&src->sequence, __ATOMIC_ACQUIRE);
+        if ( seq & 1 ) {
+            sched_yield();
+            continue;
+        }
+        if ( seq == *seen )
+            return -1;
+        memcpy(s, src, sizeof(*s));
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        if ( seq == __atomic_load_n(&src->sequence, __ATOMIC_RELAXED) ) {
+            *seen = seq;
+            return 0;
+        }
+    }
+
+    return -1;
+}
+
+/* ************************************************************************** */
+/**
+ * @brief Stop being the summary notification of a monitor.
+ * 
+ * @details The summary is cleared, so that the next notification that is
+ *          folded elects a new summary notification. The table that was
+ *          selected before is selected again, so that this can be called
+ *          before remove().
+ * 
+ * @param monitor index of the monitor.
+ * 
+ * @return 0 on success, and -1 if this process is not the summary
+ *         notification.
+ */
+int AriaSharedMem::resign(long monitor)
+{
+    struct SharedMemHeader *hdr = AriaSharedMem::header();
+    struct SharedMemSummary *s;
+    unsigned long seq;
+    long previous = MPART;
+    int status = -1;
+    if ( (hdr == NULL) || (AriaSharedMem::select(monitor) < 0) )
+        return -1;
+    if ( AriaSharedMem::memopen() == 0 ) {
+        s = &hdr->summaries[MPART];
+        if ( s->owner == AriaSharedMem::self() ) {
+            seq = __atomic_load_n(&s->sequence, __ATOMIC_RELAXED);
+            __atomic_store_n(&s->sequence, seq+1, __ATOMIC_RELAXED);
+            __atomic_thread_fence(__ATOMIC_RELEASE);
+            memset((char *) s + sizeof(s->sequence), 0,
+                   sizeof(*s) - sizeof(s->sequence));
+            __atomic_store_n(&s->sequence, seq+2, __ATOMIC_RELEASE);
+            status = 0;
+        }
+        AriaSharedMem::memclose();
+    }
+    AriaSharedMem::select(previous);
+
+    return status;
+}
+
+/* ************************************************************************** */
+/**
+ * @brief Remove the entries left behind by notifications that did not exit
+ *        cleanly from the local copy, so that they do not hold a table full
+ *        forever.
+ * 
+ * @return 1 if an entry was removed, and 0 otherwise.
+ */
+int AriaSharedMem::prune(void)
+{
+    bool   stale = false;
+    size_t i;
+    for ( i = 0; i < MLEN; ++i ) {
+        if ( MEM[i].id == 0 )
+            break;
+        if ( (AriaSharedMem::signal(MEM[i].id, 0) < 0) && (errno == ESRCH) ) {
+            AriaSharedMem::clear(i);
+            stale = true;
+        }
+    }
+    if ( stale ) {
+        AriaSharedMem::reorder();
+        AriaSharedMem::reflow(SHAREDMEM_SPACING);
+    }
+
+    return stale ? 1 : 0;
+}
+
+/* ************************************************************************** */
+/**
+ * @brief Check whether the table of a monitor is full.
+ * 
+ * @details Stale entries are removed first, see prune().
+ * 
+ * @param monitor index of the monitor.
+ * 
+ * @return 1 if the table is full, 0 if it has room, and -1 on error.
+ */
+int AriaSharedMem::isfull(long monitor)
+{
+    size_t len;
+    int    stale;
+    if ( AriaSharedMem::select(monitor) < 0 )
+        return -1;
+    if ( AriaSharedMem::memopen() < 0 )
+        return -1;
+    AriaSharedMem::update();
+    stale = AriaSharedMem::prune();
+    len = AriaSharedMem::length();
+    AriaSharedMem::memclose();
+    if ( stale )
+        AriaSharedMem::notify();
+
+    return (len == MLEN) ? 1 : 0;
+}
+
+/* ************************************************************************** */
+/**
+ * @brief Claim a place in the table of a monitor, if it has room.
+ * 
+ * @details The place is taken under the lock of the table, so that when
+ *          several processes find room at the same time, only as many as fit
+ *          get one, and the rest keep waiting. It has no position or size,
+ *          and is in no stack, until reserve() or commit() fills it in.
+ *          Stale entries are removed first, see prune().
+ * 
+ * @param monitor index of the monitor.
+ * 
+ * @param urgency urgency of the notification, see SharedMemUrgency.
+ * 
+ * @return 0 if a place was claimed, 1 if the table is full, and -1 on error.
+ */
+int AriaSharedMem::claim(long monitor, long urgency)
+{
+    struct SharedMemType data;
+    int    stale;
+    int    status = 0;
+    if ( AriaSharedMem::select(monitor) < 0 )
+        return -1;
+    if ( AriaSharedMem::memopen() < 0 )
+        return -1;
+    AriaSharedMem::update();
+    stale = AriaSharedMem::prune();
+    if ( AriaSharedMem::findcurrent() < 0 ) {
+        memset(&data, 0, sizeof(data));
+        data.id      = AriaSharedMem::self();
+        data.time    = time(0);
+        data.monitor = MPART;
+        data.gravity = -1;
+        data.count   = 1;
+        data.urgency = urgency;
+        status = (AriaSharedMem::append(&data) < 0) ? 1 : 0;
+    }
+    if ( status == 0 )
+        MRESERVED = MPART;
+    AriaSharedMem::memclose();
+    if ( stale )
+        AriaSharedMem::notify();
+
+    return status;
+}
+
+/* ************************************************************************** */
+/**
+ * @brief Sleep until the table of a monitor has room, and claim a place in
+ *        it.
+ * 
+ * @details The process sleeps on the futex of the table, which remove()
+ *          bumps, so that it uses no CPU while it waits. The value of the
+ *          futex is read before the table is checked, so that a removal in
+ *          between is not missed. Every waiter is woken, and tries to claim
+ *          the room with claim(), and those that find it taken sleep again.
+ * 
+ * @param monitor index of the monitor.
+ * 
+ * @param urgency urgency of the notification, see SharedMemUrgency.
+ * 
+ * @param timeout maximum number of milliseconds to wait, or 0 to wait
+ *        without a limit.
+ * 
+ * @return 0 once a place is claimed, 1 if the wait timed out, and -1 on
+ *         error.
+ */
+int AriaSharedMem::waitfree(long monitor, long urgency, long timeout)
+{
+    struct SharedMemHeader *hdr = AriaSharedMem::header();
+    struct timespec start;
+    struct timespec now;
+    struct timespec left;
+    unsigned int *futex;
+    unsigned int seq;
+    long elapsed;
+    int status;
+    if ( hdr == NULL )
+        return -1;
+    if ( monitor < 0 )
+        monitor = 0;
+    if ( monitor >= SHAREDMEM_MONITORS )
+        monitor = SHAREDMEM_MONITORS-1;
+
+    futex = &hdr->freed[monitor];
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    while ( true ) {
+        seq = __atomic_load_n(futex, __ATOMIC_ACQUIRE);
+        if ( (status=AriaSharedMem::claim(monitor, urgency)) <= 0 )
+            return status;
+
+        if ( timeout > 0 ) {
+            clock_gettime(CLOCK_MONOTONIC, &now);
+            elapsed = (now.tv_sec - start.tv_sec)*1000
+                + (now.tv_nsec - start.tv_nsec)/1000000;
+            if ( elapsed >= timeout )
+                return 1;
+            left.tv_sec  = (timeout - elapsed) / 1000;
+            left.tv_nsec = ((timeout - elapsed) % 1000) * 1000000;
+        }
+        syscall(SYS_futex, futex, FUTEX_WAIT, seq,
+                (timeout > 0) ? &left : NULL, NULL, 0);
+    }
+}
+
+/* ************************************************************************** */
+/**
+ * @brief Make room in the table of a monitor by removing its oldest, least
+ *        urgent notification.
+ * 
+ * @details The entry is removed, the rest of the stack moved into its place,
+ *          and the room claimed for this notification, see claim(), before
+ *          the removed one is told to quit, so that the room is there even if
+ *          it is slow to exit, and no other process takes it first. One of
+ *          several notifications in a process is only told to move, and
+ *          closes itself when it finds that its entry is gone, so that the
+ *          others stay on screen. The notifications of this process are never
+ *          removed, so that one is not made to quit by a later one in the
+ *          same batch.
+ * 
+ * @param monitor index of the monitor.
+ * 
+ * @param shift number of pixels to separate elements that overlap.
+ * 
+ * @param urgency most urgent notification that may be removed.
+ * 
+ * @param level urgency of this notification, see SharedMemUrgency.
+ * 
+ * @return 0 if a notification was removed, 1 if every notification is more
+ *         urgent, or belongs to this process, and -1 on error.
+ */
+int AriaSharedMem::evict(long monitor, long shift, long urgency, long level)
+{
+    struct SharedMemType data;
+    long   pid = getpid();
+    int    oldest = -1;
+    size_t i;
+    long   id;
+    if ( AriaSharedMem::select(monitor) < 0 )
+        return -1;
+    if ( AriaSharedMem::memopen() < 0 )
+        return -1;
+    AriaSharedMem::update();
+    for ( i = 0; i < MLEN; ++i ) {
+        if ( MEM[i].id == 0 )
+            break;
+        if ( SHAREDMEM_PID(MEM[i].id) == pid )
+            continue;
+        if ( (oldest < 0)
+             || (MEM[i].urgency < MEM[oldest].urgency)
+             || ((MEM[i].urgency == MEM[oldest].urgency)
+                 && (MEM[i].time < MEM[oldest].time)) )
+            oldest = i;
+    }
+    if ( (oldest < 0) || (MEM[oldest].urgency > urgency) ) {
+        AriaSharedMem::memclose();
+        return 1;
+    }
+
+    id = MEM[oldest].id;
+    AriaSharedMem::clear(oldest);
+    AriaSharedMem::reorder();
+    AriaSharedMem::reflow(shift);
+    if ( AriaSharedMem::findcurrent() < 0 ) {
+        memset(&data, 0, sizeof(data));
+        data.id      = AriaSharedMem::self();
+        data.time    = time(0);
+        data.monitor = MPART;
+        data.gravity = -1;
+        data.count   = 1;
+        data.urgency = level;
+        AriaSharedMem::append(&data);
+    }
+    MRESERVED = MPART;
+    AriaSharedMem::memclose();
+    AriaSharedMem::notify();
+    AriaSharedMem::signal(id, (id == SHAREDMEM_PID(id)) ? SIGTERM : SIGUSR1);
+
+    return 0;
+}
+
+/* ************************************************************************** */
+/**
+ * @brief Wake the processes waiting for the selected table to have room.
+ */
+int AriaSharedMem::wake(void)
+{
+    struct SharedMemHeader *hdr = AriaSharedMem::header();
+    if ( hdr == NULL )
+        return -1;
+
+    __atomic_add_fetch(&hdr->freed[MPART], 1, __ATOMIC_RELEASE);
+    syscall(SYS_futex, &hdr->freed[MPART], FUTEX_WAKE, INT_MAX, NULL, NULL,
+            0);
+
+    return 0;
+}
+
+/* ************************************************************************** */
+/**
+ * @brief Tell the other notifications in the local copy that their position
+ *        may have changed.
+ * 
+ * @details Each notification is sent SIGUSR1, after which it looks up its
+ *          entry and moves to it.
+ */
+int AriaSharedMem::notify(void)
+{
+    long pid = AriaSharedMem::self();
+    size_t i;
+    for ( i = 0; i < MLEN; ++i ) {
+        if ( MEM[i].id == 0 )
+            break;
+        if ( MEM[i].id == pid )
+            continue;
+        AriaSharedMem::signal(MEM[i].id, SIGUSR1);
+    }
+
+    return 0;
+}
+
+/* ************************************************************************** */
+/**
+ * @brief Send a signal to another notification.
+ * 
+ * @details An entry left behind by a notification that did not exit cleanly
+ *          may name a PID that now belongs to another program, so the signal
+ *          is only sent if the process is running the same program, and
+ *          errno is set to ESRCH otherwise, as for a process that is gone. The
+ *          signal goes to the process, which tells each of its notifications.
+ *          A signal of 0 only checks that the notification is still running.
+ * 
+ * @param id the ID of the notification.
+ * 
+ * @param sig the signal to send.
+ */
+int AriaSharedMem::signal(long id, int sig)
+{
+    char self[64];
+    char other[64];
+    char path[64];
+    if ( AriaSharedMem::readcomm("/proc/self/comm", self, sizeof(self)) < 0 )
+        return -1;
+    snprintf(path, sizeof(path), "/proc/%ld/comm", SHAREDMEM_PID(id));
+    if ( (AriaSharedMem::readcomm(path, other, sizeof(other)) < 0)
+         || (strcmp(self, other) != 0) ) {
+        errno = ESRCH;
+        return -1;
+    }
+
+    return kill(SHAREDMEM_PID(id), sig);
+}
+
+/* ************************************************************************** */
+/**
+ * @brief ID of the notification that is operated on.
+ * 
+ * @details This is the PID, unless the process displays several
+ *          notifications, and one was selected with identify().
+ */
+long AriaSharedMem::self(void)
+{
+    return (MSELF != 0) ? MSELF : getpid();
+}
+
+/* ************************************************************************** */
+/**
+ * @brief Select the notification to operate on, in a process that displays
+ *        several.
+ * 
+ * @details Entries, mailboxes, and summaries are matched against this ID
+ *          instead of the PID, until another one is selected.
+ * 
+ * @param id the ID of the notification, or 0 for the PID.
+ */
+void AriaSharedMem::identify(long id)
+{
+    MSELF = id;
+}
+
+/* ************************************************************************** */
+/**
+ * @brief Read the name of the program that a process is running.
+ * 
+ * @param path the comm file of the process, in /proc.
+ * 
+ * @param buf the buffer to store the name in.
+ * 
+ * @param len the length of the buffer.
+ */
+int AriaSharedMem::readcomm(const char *path, char *buf, size_t len)
+{
+    ssize_t n;
+    int fd;
+    if ( (fd=open(path, O_RDONLY)) < 0 )
+        return -1;
+    n = read(fd, buf, len-1);
+    close(fd);
+    if ( n <= 0 )
+        return -1;
+    buf[n] = '\0';
 
     return 0;
 }
@@ -112,34 +1276,37 @@ struct SharedMemType * AriaSharedMem::getlast(void)
  * @brief Open a file descriptor to the shared memory region.
  * 
  * @details Open a file descriptor to the shared memory region. When the file
- *          descriptor is determined, set a mutex on the file descriptor so that
- *          there are no collisions between other instances of Aria.
+ *          descriptor is determined, lock the byte range of the selected
+ *          monitor's table so that there are no collisions between other
+ *          instances of Aria, while those on other monitors can proceed. The
+ *          file is created and initialized when its header is first mapped.
  */
 int AriaSharedMem::memopen(void)
 {
     if ( FD >= 0 )
         return 0;
+    if ( AriaSharedMem::header() == NULL )
+        return -1;
 
-    bool created = false;
-    if ( access(MFILE, F_OK) < 0 ) {
-        FFLAGS  |= O_CREAT;
-        created  = true;
-    }
-
-    if ( (FD=open(MFILE, FFLAGS, FMODE)) < 0 ) {
+    if ( (FD=AriaSharedMem::fileopen(0)) < 0 ) {
         // AriaUtility::errprint("open", errno);
         return -1;
     }
-    if ( flock(FD, LOCK_EX) < 0 ) {
-        // AriaUtility::errprint("flock", errno);
+    struct flock lock = {};
+    lock.l_type   = F_WRLCK;
+    lock.l_whence = SEEK_SET;
+    lock.l_start  = MOFFSET + MPART*MSIZE;
+    lock.l_len    = MSIZE;
+    if ( fcntl(FD, F_OFD_SETLKW, &lock) < 0 ) {
+        // AriaUtility::errprint("fcntl", errno);
+        close(FD);
+        FD = -1;
         return -1;
     }
     if ( AriaSharedMem::memmap() < 0 ) {
         // AriaUtility::errprint("memmap: error.");
         return -1;
     }
-    if ( created )
-        memclear();
 
     return 0;
 }
@@ -148,15 +1315,15 @@ int AriaSharedMem::memopen(void)
 /**
  * @brief Read from the shared memory region.
  * 
- * @details Read the number of bytes, beginning from the start of the shared
- *          memory region.
+ * @details Read the number of bytes, beginning from the first element of the
+ *          selected monitor's table.
  */
 int AriaSharedMem::memread(struct SharedMemType *r, size_t s)
 {
     if ( (FD < 0) || (MADDR == NULL) )
         return -1;
 
-    if ( lseek(FD, 0, SEEK_SET) < 0 ) {
+    if ( lseek(FD, MOFFSET + MPART*MSIZE, SEEK_SET) < 0 ) {
         // AriaUtility::errprint("lseek", errno);
         return -1;
     }
@@ -176,15 +1343,15 @@ int AriaSharedMem::memread(struct SharedMemType *r, size_t s)
  * @brief Write data to the shared memory region.
  * 
  * @details Write data to the shared memory region, specifying how much data to
- *          write.  This write will begin at the start of the shared memory
- *          region.
+ *          write.  This write will begin at the first element of the selected
+ *          monitor's table.
  */
 int AriaSharedMem::memwrite(struct SharedMemType *w, size_t s)
 {
     if ( (FD < 0) || (MADDR == NULL) )
         return -1;
 
-    if ( lseek(FD, 0, SEEK_SET) < 0 ) {
+    if ( lseek(FD, MOFFSET + MPART*MSIZE, SEEK_SET) < 0 ) {
         // AriaUtility::errprint("lseek", errno);
         return -1;
     }
@@ -243,7 +1410,7 @@ int AriaSharedMem::memmap(void)
     if ( (FD < 0) )
         return -1;
 
-    MADDR = (long *) mmap(NULL, MSIZE, MPROT, MFLAGS, FD, 0);
+    MADDR = (long *) mmap(NULL, MTOTAL, MPROT, MFLAGS, FD, 0);
     if ( MADDR == MAP_FAILED ) {
         // AriaUtility::errprint("mmap", errno);
         return -1;
@@ -261,7 +1428,7 @@ int AriaSharedMem::memunmap(void)
     if ( (FD < 0) || (MADDR == NULL) )
         return -1;
 
-    if ( munmap(MADDR, MSIZE) < 0 )
+    if ( munmap(MADDR, MTOTAL) < 0 )
         // AriaUtility::errprint("munmap", errno);
 
     return 0;
@@ -321,7 +1488,12 @@ int AriaSharedMem::insert(struct SharedMemType *data, size_t index)
  * 
  * @details In the event that notifications overlap, ensure that the new
  *          notification is separated from the present notifications by the given
- *          amount.
+ *          amount. Only notifications in the same stack, i.e. with the same
+ *          gravity, are considered. Stacks with a top gravity grow down the
+ *          screen, and those with a bottom gravity grow up. Empty entries
+ *          are skipped, as the local copy has gaps while it is reflowed, as
+ *          are places that were claimed but not filled in, which are in no
+ *          stack.
  * 
  * @param data information to save in shared memory.
  * 
@@ -329,34 +1501,104 @@ int AriaSharedMem::insert(struct SharedMemType *data, size_t index)
  */
 int AriaSharedMem::displace(struct SharedMemType *data, long shift)
 {
-    // long   x      = data->x;
-    long   y      = data->y;
-    // long   w      = data->w;
-    long   h      = data->h;
-    // long   xcur   = 0;
-    long   ycur   = 0;
-    // long   xnew   = x;
-    long   ynew   = y;
-    // long   xavail = x;
-    long   yavail = y;
+    bool   up = (data->gravity == SHAREDMEM_BOTTOM_LEFT)
+        || (data->gravity == SHAREDMEM_BOTTOM_RIGHT);
+    bool   moved = (data->gravity >= 0);
+    size_t i;
+    while ( moved ) {
+        moved = false;
+        for ( i = 0; i < MLEN; ++i ) {
+            if ( MEM[i].id == 0 )
+                continue;
+            if ( MEM[i].gravity != data->gravity )
+                continue;
+            if ( (data->y >= MEM[i].y + MEM[i].h + shift)
+                 || (MEM[i].y >= data->y + data->h + shift) )
+                continue;
+
+            data->y = up ? (MEM[i].y - shift - data->h)
+                         : (MEM[i].y + MEM[i].h + shift);
+            moved   = true;
+        }
+    }
+
+    return 0;
+}
+
+/* ************************************************************************** */
+/**
+ * @brief Add a new notification to the local copy, and stack it with the
+ *        others by urgency.
+ * 
+ * @param data information to save in shared memory. On return, holds the
+ *        position that was assigned.
+ * 
+ * @param shift number of pixels to separate elements that overlap.
+ * 
+ * @return 1 if other notifications were moved to make way for it, 0 if not,
+ *         and -1 if the table is full.
+ */
+int AriaSharedMem::place(struct SharedMemType *data, long shift)
+{
+    struct SharedMemType old[MLEN];
     size_t i;
+    int    moved = 0;
+    data->home = data->y;
+    if ( data->count < 1 )
+        data->count = 1;
+    memcpy(old, MEM, MSIZE);
+    if ( AriaSharedMem::append(data) < 0 )
+        return -1;
+    AriaSharedMem::reflow(shift);
     for ( i = 0; i < MLEN; ++i ) {
-        if ( MEM[i].id == 0 )
+        if ( old[i].id == 0 )
             break;
+        if ( old[i].y != MEM[i].y )
+            moved = 1;
+    }
+    *data = MEM[AriaSharedMem::find(data->id)];
 
-        // xcur = MEM[i].x + MEM[i].w + shift;
-        ycur = MEM[i].y + MEM[i].h + shift;
-        // xnew = xavail   + w        + shift;
-        ynew = yavail   + h        + shift;
+    return moved;
+}
 
-        if ( (ynew > MEM[i].y) && (ycur > yavail) )
-            yavail = ycur;
+/* ************************************************************************** */
+/**
+ * @brief Stack the notifications in the local copy again, from their
+ *        requested positions.
+ * 
+ * @details More urgent notifications are stacked first, so that they are
+ *          closest to the corner of the monitor. Among those that are equally
+ *          urgent, each notification is displaced only by those that were
+ *          added before it, so that, after a notification is removed, the
+ *          ones that were stacked after it move into the gap.
+ * 
+ * @param shift number of pixels to separate elements that overlap.
+ */
+int AriaSharedMem::reflow(long shift)
+{
+    struct SharedMemType old[MLEN];
+    size_t i;
+    long   u;
+    long   level;
+    memcpy(old, MEM, MSIZE);
+    AriaSharedMem::clear();
+    for ( u = SHAREDMEM_URGENCY_CRITICAL; u >= SHAREDMEM_URGENCY_LOW; --u ) {
+        for ( i = 0; i < MLEN; ++i ) {
+            if ( old[i].id == 0 )
+                break;
+            level = old[i].urgency;
+            if ( level < SHAREDMEM_URGENCY_LOW )
+                level = SHAREDMEM_URGENCY_LOW;
+            if ( level > SHAREDMEM_URGENCY_CRITICAL )
+                level = SHAREDMEM_URGENCY_CRITICAL;
+            if ( level != u )
+                continue;
+            old[i].y = old[i].home;
+            AriaSharedMem::displace(&old[i], shift);
+            MEM[i] = old[i];
+        }
     }
 
-    /* Algorithm still needs to make sure that there is no overlap */
-    // data->x = (xavail == x) ? (x + shift) : xavail;
-    data->y = (yavail == y) ? (y + shift) : yavail;
-
     return 0;
 }
 
@@ -364,10 +1606,10 @@ int AriaSharedMem::displace(struct SharedMemType *data, long shift)
 /**
  * @brief Find an element in shared memory.
  * 
- * @details Searches for a match between the local copy data element's PID and
+ * @details Searches for a match between the local copy data element's ID and
  *          the given value.
  * 
- * @param id the PID to match with the local copy data.
+ * @param id the ID to match with the local copy data.
  */
 int AriaSharedMem::find(long id)
 {
@@ -384,7 +1626,7 @@ int AriaSharedMem::find(long id)
  */
 int AriaSharedMem::findcurrent(void)
 {
-    pid_t pid = getpid();
+    long pid = AriaSharedMem::self();
     size_t i;
     for ( i = 0; i < MLEN; ++i )
         if ( MEM[i].id == pid )
@@ -0,0 +1,164 @@
+/**
+ * @file sizecache.cpp
+ * @author Gabriel Gonzalez
+ * 
+ * @brief Cache of notification bubble sizes, shared between processes.
+ */
+
+#include "sizecache.hpp"
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <cstddef>
+#include <cstdlib>
+#include <string>
+
+ARIA_NAMESPACE
+
+/**
+ * @brief The mapped cache entries.
+ */
+static struct sizecache::entry* CACHE = NULL;
+
+/**
+ * @brief Path to the file that holds the cache.
+ * 
+ * @details The sizes are trusted by every notification bubble that finds
+ *          them, so the file is kept in $XDG_RUNTIME_DIR, which is private to
+ *          the user, or in /tmp, with the user ID in its name, if that is not
+ *          set.
+ * 
+ * @return The path.
+ */
+std::string sizecache::path(void)
+{
+    const char* dir = getenv("XDG_RUNTIME_DIR");
+    if (dir && (dir[0] != '\0'))
+    {
+        return std::string(dir) + "/" + PROGRAM + "-sizes";
+    }
+    return std::string("/tmp/") + PROGRAM + "-sizes-"
+        + std::to_string(getuid());
+}
+
+/**
+ * @brief Open and map the cache file.
+ * 
+ * @details The file is created, and grown to its full size, by whichever
+ *          process opens it first, and is only readable by the user. Growing
+ *          it is harmless if another process did it at the same time. A file
+ *          that belongs to another user, e.g. one made in /tmp ahead of time,
+ *          is not used. The mapping is kept for the rest of the process.
+ * 
+ * @return 0 on success, and -1 if the file can not be opened or mapped.
+ */
+int sizecache::open(void)
+{
+    size_t size = sizecache::kLength * sizeof(struct sizecache::entry);
+    struct stat statbuf;
+    void* addr;
+    int fd;
+    if (CACHE)
+    {
+        return 0;
+    }
+    if ((fd=::open(sizecache::path().c_str(),
+                   O_RDWR | O_CREAT | O_NOFOLLOW | O_CLOEXEC, 0600)) < 0)
+    {
+        return -1;
+    }
+    if ((fstat(fd, &statbuf) < 0) || (statbuf.st_uid != getuid())
+        || (((size_t) statbuf.st_size < size) && (ftruncate(fd, size) < 0)))
+    {
+        ::close(fd);
+        return -1;
+    }
+
+    addr = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (addr == MAP_FAILED)
+    {
+        return -1;
+    }
+    CACHE = (struct sizecache::entry*) addr;
+    return 0;
+}
+
+/**
+ * @brief Look up the size that was measured for a key.
+ * 
+ * @details The cache is direct mapped, so only one entry has to be checked.
+ *          Entries are read without a lock, and an entry that is being written
+ *          at the same time fails the checksum and is treated as a miss.
+ * 
+ * @param[in]  key    Hash of the notification bubble attributes.
+ * @param[out] width  The measured width.
+ * @param[out] height The measured height.
+ * 
+ * @return 0 on a hit, and -1 on a miss.
+ */
+int sizecache::lookup(unsigned long key, int& width, int& height)
+{
+    if (sizecache::open() < 0)
+    {
+        return -1;
+    }
+
+    struct sizecache::entry* e = &CACHE[key % sizecache::kLength];
+    unsigned long k = __atomic_load_n(&e->key, __ATOMIC_ACQUIRE);
+    long w = __atomic_load_n(&e->width, __ATOMIC_RELAXED);
+    long h = __atomic_load_n(&e->height, __ATOMIC_RELAXED);
+    unsigned long c = __atomic_load_n(&e->check, __ATOMIC_RELAXED);
+    if ((k != key) || (c != sizecache::checksum(k, w, h)) || (w <= 0)
+        || (h <= 0))
+    {
+        return -1;
+    }
+    width  = w;
+    height = h;
+    return 0;
+}
+
+/**
+ * @brief Store the size that was measured for a key.
+ * 
+ * @param[in] key    Hash of the notification bubble attributes.
+ * @param[in] width  The measured width.
+ * @param[in] height The measured height.
+ * 
+ * @return 0 on success, and -1 if the cache can not be opened.
+ */
+int sizecache::store(unsigned long key, int width, int height)
+{
+    if (sizecache::open() < 0)
+    {
+        return -1;
+    }
+
+    struct sizecache::entry* e = &CACHE[key % sizecache::kLength];
+    __atomic_store_n(&e->check, 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&e->width, width, __ATOMIC_RELAXED);
+    __atomic_store_n(&e->height, height, __ATOMIC_RELAXED);
+    __atomic_store_n(&e->key, key, __ATOMIC_RELEASE);
+    __atomic_store_n(&e->check, sizecache::checksum(key, width, height),
+                     __ATOMIC_RELEASE);
+    return 0;
+}
+
+/**
+ * @brief Compute the checksum of an entry.
+ * 
+ * @param[in] key    Hash of the notification bubble attributes.
+ * @param[in] width  The measured width.
+ * @param[in] height The measured height.
+ * 
+ * @return The checksum.
+ */
+unsigned long sizecache::checksum(unsigned long key, long width, long height)
+{
+    return key ^ (((unsigned long) width << 32) | (unsigned long) height)
+        ^ 0x9e3779b97f4a7c15UL;
+}
+
+ARIA_NAMESPACE_END
@@ -0,0 +1,227 @@
+/**
+ * @file startup.cpp
+ * @author Gabriel Gonzalez
+ *
+ * @brief Startup work that does not depend on the toolkit, run on helper
+ *        threads while it initializes.
+ */
+
+#include "startup.hpp"
+#include "coalesce.hpp"
+#include "config.hpp"
+#include "geometry.hpp"
+#include "overflow.hpp"
+#include "render.hpp"
+#include "sharedmem.hpp"
+#include "sizecache.hpp"
+#include "tag.hpp"
+#include "util.hpp"
+#include <time.h>
+#include <unistd.h>
+#include <csignal>
+#include <cstdlib>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+ARIA_NAMESPACE
+
+/**
+ * @brief The command line interface.
+ */
+static commandline::interface* CLI = NULL;
+
+/**
+ * @brief The threads running the startup tasks.
+ */
+static std::vector<std::thread> THREADS;
+
+/**
+ * @brief Path to the icon that was decoded.
+ */
+static std::string ICONPATH;
+
+/**
+ * @brief The decoded icon, or NULL.
+ */
+static GdkPixbuf* ICON = NULL;
+
+/**
+ * @brief Parse the config file, so that each read afterwards is a lookup.
+ */
+static void load_config(void)
+{
+    double start = util::now();
+    config::load();
+    util::profile("config", start);
+}
+
+/**
+ * @brief Decode the icon.
+ *
+ * @details If the icon can not be decoded here, nothing is kept, and the
+ *          notification bubble loads it by its path, which reports the error.
+ */
+static void decode_icon(void)
+{
+    double start = util::now();
+    ICON = gdk_pixbuf_new_from_file(ICONPATH.c_str(), NULL);
+    util::profile("icon", start);
+}
+
+/**
+ * @brief Give up the place in the stack that was reserved, if the program
+ *        exits before the notification bubble is placed.
+ */
+static void cancel_reservation(void)
+{
+    AriaSharedMem::cancel(SHAREDMEM_SPACING);
+}
+
+/**
+ * @brief Open and map the shared table of notifications, with the screen
+ *        geometry in its header, and the size cache, and reserve a place in
+ *        the stack.
+ * 
+ * @details The place is found from an estimate of the size, on the monitor
+ *          guessed from the geometry that was last published. The notification
+ *          bubble corrects both when it commits its real position.
+ */
+static void reserve_slot(void)
+{
+    double start = util::now();
+    struct render::settings s;
+    geometry::monitorlist_t monitors;
+    long index;
+    long g;
+    int w;
+    int h;
+    AriaSharedMem::header();
+    sizecache::open();
+    try
+    {
+        if ((render::resolve(*CLI, s) != 0) || (geometry::peek(monitors) < 0))
+        {
+            return;
+        }
+    }
+    catch (const std::exception&)
+    {
+        return;
+    }
+
+    index = geometry::guess(s.monitor, monitors);
+    g = geometry::gravity(s.gravity);
+    render::estimate(s, w, h);
+    int x = s.xpos;
+    int y = s.ypos;
+    geometry::place(monitors[index].workarea, g, x, y, w, h);
+    struct SharedMemType data = {.id=AriaSharedMem::self(), .time=time(0),
+                                 .x=x, .y=y, .w=w, .h=h, .monitor=index,
+                                 .gravity=g,
+                                 .home=0, .hash=coalesce::key(*CLI),
+                                 .count=1, .tag=tag::key(*CLI),
+                                 .urgency=overflow::urgency(*CLI)};
+    if (AriaSharedMem::reserve(&data, SHAREDMEM_SPACING) == 0)
+    {
+        std::atexit(&cancel_reservation);
+    }
+    util::profile("reserve", start);
+}
+
+/**
+ * @brief Start the startup tasks.
+ *
+ * @details The icon is only decoded if it is given on the command line, as the
+ *          config file is still being loaded. An icon from the config file is
+ *          loaded when the notification bubble is built. No place is reserved
+ *          in the stack when only rendering to a file.
+ * 
+ *          Once a place is reserved, the notification bubbles in the same
+ *          stack may send SIGUSR1 to move it, and duplicates and replacements
+ *          may send SIGUSR2 to update it. Both are ignored until the notification
+ *          bubble starts handling them, as it reads its place and count from
+ *          shared memory when it is placed anyway.
+ *
+ * @param[in] cli      The command line interface.
+ * @param[in] parallel Whether to run each task on its own thread, instead of
+ *                     one after another on the calling thread.
+ */
+void startup::begin(commandline::interface& cli, bool parallel)
+{
+    std::vector<void (*)(void)> tasks = {&load_config};
+    CLI = &cli;
+    if (!cli.has("render-to"))
+    {
+        std::signal(SIGUSR1, SIG_IGN);
+        std::signal(SIGUSR2, SIG_IGN);
+        tasks.push_back(&reserve_slot);
+    }
+    ICONPATH = cli.get("icon");
+    if (!ICONPATH.empty())
+    {
+        tasks.push_back(&decode_icon);
+    }
+    for (auto task : tasks)
+    {
+        if (parallel)
+        {
+            THREADS.emplace_back(task);
+        }
+        else
+        {
+            task();
+        }
+    }
+}
+
+/**
+ * @brief Wait for the startup tasks to finish.
+ */
+void startup::join(void)
+{
+    for (auto& thread : THREADS)
+    {
+        thread.join();
+    }
+    THREADS.clear();
+}
+
+/**
+ * @brief Take the icon that was decoded during startup.
+ *
+ * @details Must only be called after join().
+ *
+ * @param[in] path Path to the icon.
+ *
+ * @return The icon, which the caller now owns, or NULL if the icon at that
+ *         path was not decoded.
+ */
+GdkPixbuf* startup::take_icon(const std::string& path)
+{
+    GdkPixbuf* icon = NULL;
+    if (ICON && (path == ICONPATH))
+    {
+        icon = ICON;
+        ICON = NULL;
+    }
+    return icon;
+}
+
+/**
+ * @brief Free the icon that was decoded during startup, if it was not taken.
+ *
+ * @details Must only be called after join(). Used when the notification is
+ *          not drawn by GTK, or was not built, so that the icon is not kept
+ *          for the rest of the process.
+ */
+void startup::drop_icon(void)
+{
+    if (ICON)
+    {
+        g_object_unref(ICON);
+        ICON = NULL;
+    }
+}
+
+ARIA_NAMESPACE_END
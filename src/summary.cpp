@@ -0,0 +1,141 @@
+/**
+ * @file summary.cpp
+ * @author Gabriel Gonzalez
+ * 
+ * @brief Fold notifications into a single summary notification, when too
+ *        many are visible.
+ */
+
+#include "summary.hpp"
+#include "config.hpp"
+#include "geometry.hpp"
+#include "overflow.hpp"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+ARIA_NAMESPACE
+
+/**
+ * @brief Index of the monitor whose summary this process displays, or -1.
+ */
+static long MONITOR = -1;
+
+/**
+ * @brief Sequence counter of the summary that was last read.
+ */
+static unsigned long SEEN = 0;
+
+/**
+ * @brief Fold the notification into the summary notification of its monitor,
+ *        if too many notifications are visible.
+ * 
+ * @details The monitor is guessed from the geometry in shared memory, as with
+ *          --on-full. Critical notifications are never folded, so that they
+ *          are not hidden behind the summary. If this process is elected to
+ *          display the summary, the notification bubble displays it instead
+ *          of the title and body that were given, see collect().
+ * 
+ * @param[in] cli The command line interface.
+ * 
+ * @return True if the notification was folded into the summary notification
+ *         of another process, in which case there is nothing left to display,
+ *         and false otherwise.
+ */
+bool summary::fold(commandline::interface& cli)
+{
+    std::string value = cli.get("max-visible");
+    std::string spec = cli.get("monitor");
+    std::string title = cli.get("title");
+    geometry::monitorlist_t monitors;
+    long index = 0;
+    if (value.empty())
+    {
+        value = config::read("max-visible");
+    }
+    long limit = std::strtol(value.c_str(), NULL, 10);
+    if ((limit <= 0) || (overflow::urgency(cli) == SHAREDMEM_URGENCY_CRITICAL))
+    {
+        return false;
+    }
+    if (spec.empty())
+    {
+        spec = config::read("monitor");
+    }
+    if (geometry::peek(monitors) == 0)
+    {
+        index = geometry::guess(spec, monitors);
+    }
+    if (title.empty())
+    {
+        title = cli.get("body");
+    }
+
+    switch (AriaSharedMem::fold(index, limit, title.c_str()))
+    {
+    case 1:
+        return true;
+    case 0:
+        MONITOR = index;
+        return false;
+    default:
+        return false;
+    }
+}
+
+/**
+ * @brief Read the summary, if this process displays it and it changed.
+ * 
+ * @details The title is the number of notifications that were folded, and the
+ *          body lists their most recent titles, newest first. In a process that
+ *          displays several notifications, only the one that was elected reads
+ *          it.
+ * 
+ * @param[out] p The title and body of the summary notification.
+ * 
+ * @return True if there is a new summary to display, and false otherwise.
+ */
+bool summary::collect(struct SharedMemPayload& p)
+{
+    struct SharedMemSummary s;
+    std::string body;
+    unsigned long seen = SEEN;
+    if ((MONITOR < 0) || (AriaSharedMem::summary(MONITOR, &seen, &s) != 0)
+        || (s.owner != AriaSharedMem::self()))
+    {
+        return false;
+    }
+    SEEN = seen;
+    for (long k = 1; k <= SHAREDMEM_SUMMARY; ++k)
+    {
+        const char* title = s.titles[(s.next - k + SHAREDMEM_SUMMARY)
+                                     % SHAREDMEM_SUMMARY];
+        if (title[0] != '\0')
+        {
+            body += (body.empty() ? "" : "\n") + std::string(title);
+        }
+    }
+
+    p = {};
+    snprintf(p.title, sizeof(p.title), "+%ld more", s.count);
+    strncpy(p.body, body.c_str(), sizeof(p.body)-1);
+    p.fields = SHAREDMEM_FIELD_TITLE | SHAREDMEM_FIELD_BODY;
+    return true;
+}
+
+/**
+ * @brief Stop displaying the summary.
+ * 
+ * @details Called when the summary notification is dismissed, so that the
+ *          next notification that is folded is elected to display a new one.
+ */
+void summary::resign(void)
+{
+    if ((MONITOR >= 0) && (AriaSharedMem::resign(MONITOR) == 0))
+    {
+        MONITOR = -1;
+    }
+}
+
+ARIA_NAMESPACE_END
@@ -0,0 +1,84 @@
+/**
+ * @file tag.cpp
+ * @author Gabriel Gonzalez
+ * 
+ * @brief Replace the contents of a tagged notification that is on screen.
+ */
+
+#include "tag.hpp"
+#include "sharedmem.hpp"
+#include "util.hpp"
+#include <climits>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+ARIA_NAMESPACE
+
+/**
+ * @brief Hash the tag of a notification.
+ * 
+ * @param[in] cli The command line interface.
+ * 
+ * @return The hash, or 0 if the notification has no tag.
+ */
+unsigned long tag::key(commandline::interface& cli)
+{
+    std::string name = cli.get("tag");
+    if (name.empty())
+    {
+        return 0;
+    }
+    unsigned long hash = util::hash(name);
+    return (hash != 0) ? hash : 1;
+}
+
+/**
+ * @brief Hand the notification to the notification on screen with the same
+ *        tag.
+ * 
+ * @details Only the title, body, and icon that are given on the command line
+ *          are replaced, so that e.g. a progress update only has to send the
+ *          body. The icon is sent as an absolute path, as the notification on
+ *          screen may have been started from another directory. Text that
+ *          does not fit in the mailbox is cut short.
+ * 
+ * @param[in] cli The command line interface.
+ * 
+ * @return True if the notification was handed over, in which case there is
+ *         nothing left to display, and false otherwise.
+ */
+bool tag::forward(commandline::interface& cli)
+{
+    struct SharedMemPayload p = {};
+    std::string title = cli.get("title");
+    std::string body = cli.get("body");
+    std::string icon = cli.get("icon");
+    char path[PATH_MAX];
+    if ((p.tag=tag::key(cli)) == 0)
+    {
+        return false;
+    }
+    if (!title.empty())
+    {
+        strncpy(p.title, title.c_str(), sizeof(p.title)-1);
+        p.fields |= SHAREDMEM_FIELD_TITLE;
+    }
+    if (!body.empty())
+    {
+        strncpy(p.body, body.c_str(), sizeof(p.body)-1);
+        p.fields |= SHAREDMEM_FIELD_BODY;
+    }
+    if (!icon.empty())
+    {
+        if (!realpath(icon.c_str(), path))
+        {
+            return false;
+        }
+        strncpy(p.icon, path, sizeof(p.icon)-1);
+        p.fields |= SHAREDMEM_FIELD_ICON;
+    }
+    return AriaSharedMem::deliver(&p) == 0;
+}
+
+ARIA_NAMESPACE_END
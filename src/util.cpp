@@ -6,13 +6,21 @@
  */
 
 #include "util.hpp"
+#include <pango/pango.h>
 #include <string>
+#include <cstdio>
+#include <cstdlib>
+#include <time.h>
 
 ARIA_NAMESPACE
 
 /**
  * @brief Replace all instances of a subtring in a string.
  * 
+ * @details The result is built in a single pass, copying the text between
+ *          each match, instead of replacing each match in place, which would
+ *          move the rest of the string every time.
+ * 
  * @param[in,out] text    The text to replace the substring in.
  * @param[in]     find    The string to find in the input string.
  * @param[in]     replace The string to replace the substring with.
@@ -22,14 +30,510 @@ ARIA_NAMESPACE
  */
 std::string util::replace_all(std::string& text, std::string find, std::string replace)
 {
-    size_t length = replace.length();
+    if (find.empty())
+    {
+        return text;
+    }
+
+    std::string result;
+    size_t length = find.length();
+    size_t last = 0;
     size_t i;
-    for(i=0; (i=text.find(find, i)) != std::string::npos; )
+    result.reserve(text.length());
+    for(i=0; (i=text.find(find, i)) != std::string::npos; i += length)
     {
-        text.replace(i, length, replace);
-        i += length;
+        result.append(text, last, i-last);
+        result.append(replace);
+        last = i + length;
     }
+    result.append(text, last, std::string::npos);
+    text.swap(result);
     return text;
 }
 
+/**
+ * @brief Decode a fixed number of hexadecimal digits.
+ * 
+ * @param[in]  s     The hexadecimal digits.
+ * @param[in]  count Number of digits to decode.
+ * @param[out] value The decoded value.
+ * 
+ * @return 0 on success, and -1 if a character is not a hexadecimal digit.
+ */
+static int decode_hex(const unsigned char* s, size_t count,
+                      unsigned long& value)
+{
+    size_t i;
+    value = 0;
+    for (i=0; i < count; ++i)
+    {
+        unsigned char c = s[i];
+        value <<= 4;
+        if ((c >= '0') && (c <= '9'))
+        {
+            value |= c - '0';
+        }
+        else if ((c >= 'a') && (c <= 'f'))
+        {
+            value |= c - 'a' + 10;
+        }
+        else if ((c >= 'A') && (c <= 'F'))
+        {
+            value |= c - 'A' + 10;
+        }
+        else
+        {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+/**
+ * @brief Decode a '\\uXXXX' escape sequence, or a surrogate pair of them.
+ * 
+ * @param[in]  s      The text, starting at the backslash.
+ * @param[in]  length Number of bytes left in the text.
+ * @param[out] cp     The decoded code point.
+ * 
+ * @return The number of bytes that make up the escape sequence. If it is not a
+ *         valid escape sequence, return 0.
+ */
+static size_t decode_escape(const unsigned char* s, size_t length,
+                            unsigned long& cp)
+{
+    unsigned long lo;
+    if ((length < 6) || (decode_hex(s+2, 4, cp) < 0))
+    {
+        return 0;
+    }
+    if ((cp >= 0xDC00) && (cp <= 0xDFFF))
+    {
+        return 0;
+    }
+    if ((cp < 0xD800) || (cp > 0xDBFF))
+    {
+        return 6;
+    }
+    if ((length < 12) || (s[6] != '\\') || (s[7] != 'u')
+        || (decode_hex(s+8, 4, lo) < 0) || (lo < 0xDC00) || (lo > 0xDFFF))
+    {
+        return 0;
+    }
+    cp = 0x10000 + ((cp - 0xD800) << 10) + (lo - 0xDC00);
+    return 12;
+}
+
+/**
+ * @brief Determine the length of the UTF-8 sequence at the start of the text.
+ * 
+ * @details Overlong encodings, surrogates, and code points past U+10FFFF are
+ *          all invalid.
+ * 
+ * @param[in] s      The text, starting at the lead byte of the sequence.
+ * @param[in] length Number of bytes left in the text.
+ * 
+ * @return The number of bytes in the sequence, or 0 if it is invalid.
+ */
+static size_t utf8_length(const unsigned char* s, size_t length)
+{
+    unsigned char c = s[0];
+    unsigned long cp;
+    unsigned long min;
+    size_t n;
+    size_t i;
+    if ((c & 0xE0) == 0xC0)
+    {
+        n = 2;
+        cp = c & 0x1F;
+        min = 0x80;
+    }
+    else if ((c & 0xF0) == 0xE0)
+    {
+        n = 3;
+        cp = c & 0x0F;
+        min = 0x800;
+    }
+    else if ((c & 0xF8) == 0xF0)
+    {
+        n = 4;
+        cp = c & 0x07;
+        min = 0x10000;
+    }
+    else
+    {
+        return 0;
+    }
+    if (n > length)
+    {
+        return 0;
+    }
+    for (i=1; i < n; ++i)
+    {
+        if ((s[i] & 0xC0) != 0x80)
+        {
+            return 0;
+        }
+        cp = (cp << 6) | (s[i] & 0x3F);
+    }
+    if ((cp < min) || (cp > 0x10FFFF) || ((cp >= 0xD800) && (cp <= 0xDFFF)))
+    {
+        return 0;
+    }
+    return n;
+}
+
+/**
+ * @brief Append a code point to the text, encoded as UTF-8.
+ * 
+ * @param[in,out] text The text to append to.
+ * @param[in]     cp   The code point.
+ */
+static void append_utf8(std::string& text, unsigned long cp)
+{
+    if (cp < 0x80)
+    {
+        text += (char) cp;
+    }
+    else if (cp < 0x800)
+    {
+        text += (char) (0xC0 | (cp >> 6));
+        text += (char) (0x80 | (cp & 0x3F));
+    }
+    else if (cp < 0x10000)
+    {
+        text += (char) (0xE0 | (cp >> 12));
+        text += (char) (0x80 | ((cp >> 6) & 0x3F));
+        text += (char) (0x80 | (cp & 0x3F));
+    }
+    else
+    {
+        text += (char) (0xF0 | (cp >> 18));
+        text += (char) (0x80 | ((cp >> 12) & 0x3F));
+        text += (char) (0x80 | ((cp >> 6) & 0x3F));
+        text += (char) (0x80 | (cp & 0x3F));
+    }
+}
+
+/**
+ * @brief Append an ASCII character to the text, with control characters
+ *        filtered the way normalize() does.
+ * 
+ * @details A carriage return becomes a line break, form feeds and vertical
+ *          tabs become spaces, and other control characters, other than line
+ *          breaks and tabs, are dropped.
+ * 
+ * @param[in,out] text The text to append to.
+ * @param[in]     c    The character.
+ */
+static void append_ascii(std::string& text, unsigned char c)
+{
+    if (c == '\r')
+    {
+        text += '\n';
+    }
+    else if ((c == '\f') || (c == '\v'))
+    {
+        text += ' ';
+    }
+    else if (((c >= 0x20) && (c != 0x7f)) || (c == '\n') || (c == '\t'))
+    {
+        text += c;
+    }
+}
+
+/**
+ * @brief Normalize the title or body text of a notification.
+ * 
+ * @details The text is scanned once, and the output is allocated once, with
+ *          the length of the input. Decoding an escape sequence or a line
+ *          ending never makes the text longer, only an invalid UTF-8 byte does.
+ * 
+ *          - The escape sequences '\\n', '\\t', '\\\\' and '\\uXXXX' are
+ *            decoded. Any other backslash is a line break, as it has always
+ *            been.
+ *          - Carriage returns are converted to line breaks, form feeds and
+ *            vertical tabs to spaces, and other control characters are
+ *            dropped, including those written as '\\uXXXX'. Trailing
+ *            whitespace is removed.
+ *          - Invalid UTF-8 sequences are replaced with U+FFFD.
+ * 
+ * @param[in] text The text to normalize.
+ * 
+ * @return The normalized text.
+ */
+std::string util::normalize(const std::string& text)
+{
+    std::string result;
+    const unsigned char* s = (const unsigned char*) text.data();
+    size_t length = text.length();
+    size_t i = 0;
+    result.reserve(length);
+
+    while (i < length)
+    {
+        unsigned char c = s[i];
+        if (c == '\\')
+        {
+            char e = (i+1 < length) ? s[i+1] : '\0';
+            unsigned long cp;
+            size_t n;
+            if (e == 'n')
+            {
+                result += '\n';
+                i += 2;
+            }
+            else if (e == 't')
+            {
+                result += '\t';
+                i += 2;
+            }
+            else if (e == '\\')
+            {
+                result += '\\';
+                i += 2;
+            }
+            else if ((e == 'u') && ((n=decode_escape(s+i, length-i, cp)) > 0))
+            {
+                if (cp < 0x80)
+                {
+                    append_ascii(result, cp);
+                }
+                else
+                {
+                    append_utf8(result, cp);
+                }
+                i += n;
+            }
+            else
+            {
+                result += '\n';
+                i += 1;
+            }
+        }
+        else if (c == '\r')
+        {
+            result += '\n';
+            i += ((i+1 < length) && (s[i+1] == '\n')) ? 2 : 1;
+        }
+        else if (c < 0x80)
+        {
+            append_ascii(result, c);
+            i += 1;
+        }
+        else
+        {
+            size_t n = utf8_length(s+i, length-i);
+            if (n > 0)
+            {
+                result.append((const char*) s+i, n);
+                i += n;
+            }
+            else
+            {
+                append_utf8(result, 0xFFFD);
+                i += 1;
+            }
+        }
+    }
+
+    size_t end = result.find_last_not_of(" \t\n");
+    result.resize((end == std::string::npos) ? 0 : end+1);
+    return result;
+}
+
+/**
+ * @brief Cut text down to what can be displayed in a number of lines.
+ * 
+ * @details Count the lines the text would take up if every line were wrapped
+ *          at the maximum width, and cut it at the start of the first line past
+ *          the limit, marking the cut with an ellipsis. A line can hold more
+ *          than the maximum number of characters when they are narrow, so twice
+ *          the width is allowed on each line, and one extra line is kept,
+ *          leaving the exact ellipsization to the text layout.
+ * 
+ *          Whatever the limits are, or if there are none, the text is also cut
+ *          after kMaxChars characters, so that the cost of laying it out stays
+ *          bounded, e.g. for a single long line with no maximum width.
+ * 
+ * @param[in,out] text  The text to truncate.
+ * @param[in]     lines Maximum number of lines. 0 means there is no limit
+ *                      other than kMaxChars.
+ * @param[in]     width Maximum width of a line, in characters. 0 means there is
+ *                      no limit other than kMaxChars.
+ */
+void util::truncate(std::string& text, int lines, int width)
+{
+    size_t length = text.length();
+    size_t column = 0;
+    size_t maxcolumn = 2 * (size_t) width;
+    size_t count = 0;
+    int line = 0;
+    size_t i;
+    for (i=0; i < length; ++i)
+    {
+        unsigned char c = text[i];
+        if ((c & 0xC0) == 0x80)
+        {
+            continue;
+        }
+        if (count++ == util::kMaxChars)
+        {
+            break;
+        }
+        if ((lines > 0)
+            && ((c == '\n') || ((width > 0) && (column == maxcolumn))))
+        {
+            column = 0;
+            if (++line > lines)
+            {
+                break;
+            }
+        }
+        if (c != '\n')
+        {
+            ++column;
+        }
+    }
+    if (i < length)
+    {
+        text.resize(i);
+        text += "\u2026";
+    }
+}
+
+/**
+ * @brief Hash a string.
+ * 
+ * @details Uses the 64-bit FNV-1a hash, which is fast for short strings and
+ *          gives the same value in every process.
+ * 
+ * @param[in] text The string to hash.
+ * 
+ * @return The hash.
+ */
+unsigned long util::hash(const std::string& text)
+{
+    unsigned long h = 0xcbf29ce484222325UL;
+    for (unsigned char c : text)
+    {
+        h ^= c;
+        h *= 0x100000001b3UL;
+    }
+    return h;
+}
+
+/**
+ * @brief Current time of a monotonic clock, in milliseconds.
+ * 
+ * @return The time in milliseconds. Only differences between two values are
+ *         meaningful.
+ */
+double util::now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (ts.tv_sec * 1000.0) + (ts.tv_nsec / 1000000.0);
+}
+
+/**
+ * @brief Print the time elapsed since start, when profiling is enabled.
+ * 
+ * @details Profiling is enabled by setting the ARIA_PROFILE environment
+ *          variable. Timings are printed to stderr so that they do not mix
+ *          with regular output.
+ * 
+ * @param[in] label Name of the step that was timed.
+ * @param[in] start Time, from now(), at which the step started.
+ */
+void util::profile(const char* label, double start)
+{
+    static const bool enabled = (getenv("ARIA_PROFILE") != NULL);
+    if (!enabled)
+    {
+        return;
+    }
+    fprintf(stderr, "%s: %s: %.3f ms\n", PROGRAM, label, util::now()-start);
+}
+
+/**
+ * @brief Parse the Pango markup in text, if it contains any.
+ * 
+ * @details Text without a '<' or '&' can not contain any markup, which is the
+ *          case for most text, so the parser is only run when one of them is
+ *          found. Text that fails to parse is not considered markup, and is
+ *          left as it is. Otherwise, the tags are stripped from the text and
+ *          returned as a list of attributes, so that the text is not parsed a
+ *          second time when it is displayed.
+ * 
+ * @param[in,out] text  The text to parse.
+ * @param[out]    attrs The attributes of the markup, which the caller owns, or
+ *                      NULL if the text is not markup. May itself be NULL if
+ *                      the attributes are not needed.
+ * 
+ * @return True if the text is valid markup that contains a tag or an entity,
+ *         and false otherwise.
+ */
+bool util::parse_markup(std::string& text, PangoAttrList** attrs)
+{
+    char* plain = NULL;
+    if (attrs)
+    {
+        *attrs = NULL;
+    }
+    if ((text.find_first_of("<&") == std::string::npos)
+        || !pango_parse_markup(text.c_str(), text.length(), 0, attrs, &plain,
+                               NULL, NULL))
+    {
+        return false;
+    }
+    text = plain;
+    g_free(plain);
+    return true;
+}
+
+/**
+ * @brief Check if the color string is in a hex format.
+ * 
+ * @param[in] color The color string to check.
+ * 
+ * @return True if the input is a color string, and false otherwise.
+ */
+bool util::is_hex_color(std::string& color)
+{
+    int start;
+    if (color[0] == '#') {
+        return true;
+    }
+    if (color.length() != 6) {
+        return false;
+    }
+    start = 0;
+    if ((color.substr(0, 2) == "0x") || (color.substr(0, 2) == "0X")) {
+        start = 2;
+    }
+    return (color.find_first_not_of("0123456789ABCDEFabcdef", start) == std::string::npos);
+}
+
+/**
+ * @brief Parse the color string and convert it to a '#123456' string if the
+ *        input is a hex string.
+ * 
+ * @param[in] color The color hex string.
+ * 
+ * @return The color string.
+ */
+std::string util::fix_color(std::string& color)
+{
+    if ((color.substr(0, 2) == "0x") || (color.substr(0, 2) == "0X")) {
+        color.erase(0, 2);
+    }
+    if (util::is_hex_color(color)) {
+        if (color[0] != '#') {
+            color.insert(0, 1, '#');
+        }
+    }
+    return color;
+}
+
 ARIA_NAMESPACE_END
@@ -0,0 +1,593 @@
+/**
+ * @file x11bubble.cpp
+ * @author Gabriel Gonzalez
+ * 
+ * @brief The Aria notification bubble, drawn directly with Xlib and Cairo,
+ *        without GTK.
+ */
+
+#include "x11bubble.hpp"
+#include "coalesce.hpp"
+#include "geometry.hpp"
+#include "overflow.hpp"
+#include "progress.hpp"
+#include "sharedmem.hpp"
+#include "summary.hpp"
+#include "tag.hpp"
+#include "util.hpp"
+#include <X11/Xatom.h>
+#include <X11/Xutil.h>
+#include <cairo-xlib.h>
+#include <poll.h>
+#include <signal.h>
+#include <sys/signalfd.h>
+#include <time.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <csignal>
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+ARIA_NAMESPACE
+
+/**
+ * @brief Shortest time between two updates of the progress bar, in
+ *        milliseconds, which is one frame at 60 Hz.
+ */
+static const double kFrameTime = 1000.0 / 60;
+
+/**
+ * @brief Construct the notification bubble, without connecting to the X server
+ *        yet.
+ */
+x11bubble::x11bubble() :
+    display_(NULL),
+    window_(None),
+    visual_(NULL),
+    colormap_(None),
+    depth_(0),
+    surface_(NULL),
+    settings_(),
+    layout_(),
+    x_(0),
+    y_(0),
+    index_(0),
+    key_(0),
+    tagkey_(0),
+    urgency_(SHAREDMEM_URGENCY_NORMAL),
+    seen_(0),
+    deadline_(0),
+    progress_(),
+    sigfd_(-1),
+    done_(false)
+{
+    this->progress_.fd = -1;
+}
+
+/**
+ * @brief Destroy the window and close the connection to the X server.
+ */
+x11bubble::~x11bubble()
+{
+    render::release(this->layout_);
+    if (this->surface_)
+    {
+        cairo_surface_destroy(this->surface_);
+    }
+    if (this->display_)
+    {
+        if (this->window_ != None)
+        {
+            XDestroyWindow(this->display_, this->window_);
+        }
+        if (this->colormap_ != None)
+        {
+            XFreeColormap(this->display_, this->colormap_);
+        }
+        XCloseDisplay(this->display_);
+    }
+    if (this->sigfd_ >= 0)
+    {
+        close(this->sigfd_);
+    }
+    progress::close(this->progress_);
+}
+
+/**
+ * @brief Build the notification bubble and set all attributes.
+ * 
+ * @details Resolve the attributes, connect to the X server, and lay out the
+ *          notification bubble. The signals that the program handles are
+ *          blocked and read from a signalfd, so that they are handled in the
+ *          event loop. This is done before the notification bubble is added to
+ *          shared memory, where other notification bubbles may signal it.
+ * 
+ * @param[in] cli The command line interface, containing all the command line
+ *                information.
+ * 
+ * @return 0 on success. Any other value is an error, using the same values as
+ *         notification::build(), or 10 if unable to connect to the X server.
+ */
+int x11bubble::build(commandline::interface& cli)
+{
+    struct SharedMemPayload folded = {};
+    cairo_surface_t* scratch;
+    cairo_t* cr;
+    sigset_t mask;
+    int status;
+    if ((status=render::resolve(cli, this->settings_)) != 0)
+    {
+        return status;
+    }
+    if (summary::collect(folded))
+    {
+        this->settings_.title = folded.title;
+        this->settings_.body  = folded.body;
+    }
+    if (cli.has("progress")
+        && (progress::open(cli.get("progress"), this->progress_) < 0))
+    {
+        fprintf(stderr, "%s: Unable to open progress source '%s'.\n",
+                PROGRAM, cli.get("progress").c_str());
+        return 13;
+    }
+    if (!(this->display_=XOpenDisplay(NULL)))
+    {
+        fprintf(stderr, "%s: Unable to connect to the X server.\n", PROGRAM);
+        return 10;
+    }
+    this->key_     = folded.fields ? 0 : coalesce::key(cli);
+    this->tagkey_  = folded.fields ? 0 : tag::key(cli);
+    this->urgency_ = std::max(overflow::urgency(cli),
+                              (long) SHAREDMEM_URGENCY_LOW);
+
+    sigemptyset(&mask);
+    sigaddset(&mask, SIGUSR1);
+    sigaddset(&mask, SIGUSR2);
+    sigaddset(&mask, SIGINT);
+    sigaddset(&mask, SIGQUIT);
+    sigaddset(&mask, SIGTERM);
+    sigprocmask(SIG_BLOCK, &mask, NULL);
+    std::signal(SIGUSR1, SIG_DFL);
+    std::signal(SIGUSR2, SIG_DFL);
+    this->sigfd_ = signalfd(-1, &mask, SFD_CLOEXEC);
+
+    double start = util::now();
+    scratch = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, 1, 1);
+    cr = cairo_create(scratch);
+    status = render::lay_out(cr, this->settings_, this->layout_);
+    cairo_destroy(cr);
+    cairo_surface_destroy(scratch);
+    util::profile("layout", start);
+    return (status < 0) ? 2 : 0;
+}
+
+/**
+ * @brief Display the notification bubble.
+ * 
+ * @details Place the notification bubble, and then create and map its window
+ *          at that position.
+ * 
+ * @return 0 on success, and 10 if the window could not be created.
+ */
+int x11bubble::show(void)
+{
+    this->reposition();
+    if (this->create_window() < 0)
+    {
+        return 10;
+    }
+    this->set_properties();
+    XMapRaised(this->display_, this->window_);
+    XFlush(this->display_);
+    return 0;
+}
+
+/**
+ * @brief Handle events until the notification bubble times out, or the
+ *        program is told to quit.
+ * 
+ * @details Wait on both the connection to the X server and the signalfd, so
+ *          that the program sleeps until there is something to do. When done,
+ *          the notification bubble is removed from shared memory, which tells
+ *          the rest of its stack to move into its place.
+ * 
+ *          The source of the progress bar, if any, is waited on as well. After
+ *          it is read, it is not waited on again until a frame has passed,
+ *          when the latest update is displayed, so that it is read, and the
+ *          bar drawn, at most once per frame however fast the updates are
+ *          written. There is no timeout until the source reaches its end.
+ * 
+ * @return 0 on success.
+ */
+int x11bubble::run(void)
+{
+    struct pollfd fds[3] = {{ConnectionNumber(this->display_), POLLIN, 0},
+                            {this->sigfd_, POLLIN, 0},
+                            {this->progress_.fd, POLLIN, 0}};
+    double next = 0;
+    double now;
+    double left;
+    int timeout;
+    XEvent event;
+    this->deadline_ = util::now() + (this->settings_.time * 1000.0);
+    while (!this->done_)
+    {
+        while (XPending(this->display_))
+        {
+            XNextEvent(this->display_, &event);
+            this->handle_event(event);
+        }
+        now = util::now();
+        if ((fds[2].fd < 0) && (this->progress_.fd >= 0)
+            && !this->progress_.eof && (now >= next))
+        {
+            this->show_progress();
+            fds[2].fd = this->progress_.fd;
+        }
+        if (this->progress_.eof || (this->progress_.fd < 0))
+        {
+            if ((left=this->deadline_-now) <= 0)
+            {
+                break;
+            }
+            timeout = (int) std::ceil(left);
+        }
+        else
+        {
+            timeout = (fds[2].fd < 0) ? (int) std::ceil(next-now) : -1;
+        }
+        if ((poll(fds, 3, timeout) < 0) && (errno != EINTR))
+        {
+            break;
+        }
+        if (fds[1].revents & POLLIN)
+        {
+            this->handle_signal();
+        }
+        if ((fds[2].fd >= 0) && fds[2].revents)
+        {
+            progress::read(this->progress_);
+            fds[2].fd = -1;
+            next = util::now() + kFrameTime;
+            if (this->progress_.eof)
+            {
+                this->show_progress();
+                this->deadline_ = util::now()
+                    + (this->settings_.time * 1000.0);
+            }
+        }
+    }
+    AriaSharedMem::remove(SHAREDMEM_SPACING);
+    summary::resign();
+    return 0;
+}
+
+/**
+ * @brief Create the window of the notification bubble.
+ * 
+ * @details The window is override-redirect, so that the window manager does
+ *          not decorate or place it. A 32-bit visual is used if there is one,
+ *          so that the corners and background can be translucent, as with the
+ *          RGBA visual of the notification class. Without a compositor, the
+ *          background is drawn opaque, as notification::on_draw() does.
+ * 
+ * @return 0 on success, and -1 if the window could not be created.
+ */
+int x11bubble::create_window(void)
+{
+    int screen = DefaultScreen(this->display_);
+    Window root = RootWindow(this->display_, screen);
+    std::string selection = "_NET_WM_CM_S" + std::to_string(screen);
+    Atom cm = XInternAtom(this->display_, selection.c_str(), False);
+    XSetWindowAttributes attr;
+    unsigned long mask = CWOverrideRedirect | CWBackPixel | CWBorderPixel
+        | CWEventMask;
+    XVisualInfo info;
+
+    attr.override_redirect = True;
+    attr.background_pixel  = 0;
+    attr.border_pixel      = 0;
+    attr.event_mask        = ExposureMask;
+    if (XMatchVisualInfo(this->display_, screen, 32, TrueColor, &info))
+    {
+        this->visual_   = info.visual;
+        this->depth_    = info.depth;
+        this->colormap_ = XCreateColormap(this->display_, root, this->visual_,
+                                          AllocNone);
+        attr.colormap   = this->colormap_;
+        mask           |= CWColormap;
+    }
+    else
+    {
+        this->visual_ = DefaultVisual(this->display_, screen);
+        this->depth_  = DefaultDepth(this->display_, screen);
+    }
+    if ((this->depth_ != 32)
+        || (XGetSelectionOwner(this->display_, cm) == None))
+    {
+        this->settings_.background.alpha = 1.0;
+    }
+
+    this->window_ = XCreateWindow(this->display_, root, this->x_, this->y_,
+                                  this->layout_.width, this->layout_.height, 0,
+                                  this->depth_, InputOutput, this->visual_,
+                                  mask, &attr);
+    if (this->window_ == None)
+    {
+        return -1;
+    }
+    XSelectInput(this->display_, root, PropertyChangeMask);
+    this->surface_ = cairo_xlib_surface_create(this->display_, this->window_,
+                                               this->visual_,
+                                               this->layout_.width,
+                                               this->layout_.height);
+    return 0;
+}
+
+/**
+ * @brief Set the properties that identify the window as a notification to the
+ *        window manager and compositor.
+ */
+void x11bubble::set_properties(void)
+{
+    Atom type = XInternAtom(this->display_, "_NET_WM_WINDOW_TYPE", False);
+    Atom notify = XInternAtom(this->display_,
+                              "_NET_WM_WINDOW_TYPE_NOTIFICATION", False);
+    Atom pidatom = XInternAtom(this->display_, "_NET_WM_PID", False);
+    long pid = getpid();
+    char name[] = PROGRAM;
+    char cls[] = PROGRAM;
+    XClassHint hint = {name, cls};
+    XChangeProperty(this->display_, this->window_, type, XA_ATOM, 32,
+                    PropModeReplace, (unsigned char*) &notify, 1);
+    XChangeProperty(this->display_, this->window_, pidatom, XA_CARDINAL, 32,
+                    PropModeReplace, (unsigned char*) &pid, 1);
+    XSetClassHint(this->display_, this->window_, &hint);
+    XStoreName(this->display_, this->window_, PROGRAM);
+}
+
+/**
+ * @brief Move the notification bubble to the desired position.
+ * 
+ * @details Place the notification bubble in the work area of the selected
+ *          monitor, add it to its stack in shared memory, or update its entry
+ *          in place, and move the window if it already exists. If it moved to
+ *          another monitor, it leaves the stack of the old one first.
+ */
+void x11bubble::reposition(void)
+{
+    long g = geometry::gravity(this->settings_.gravity);
+    int w = this->layout_.width;
+    int h = this->layout_.height;
+    int x = this->settings_.xpos;
+    int y = this->settings_.ypos;
+    int index = 0;
+    struct geometry::monitor m;
+    if (geometry::select(this->display_, this->settings_.monitor, index, m) == 0)
+    {
+        geometry::place(m.workarea, g, x, y, w, h);
+    }
+    if ((this->window_ != None) && (index != this->index_))
+    {
+        AriaSharedMem::select(this->index_);
+        AriaSharedMem::remove(SHAREDMEM_SPACING);
+    }
+    struct SharedMemType data = {.id=getpid(), .time=time(0), .x=x, .y=y,
+                                 .w=w, .h=h, .monitor=index, .gravity=g,
+                                 .home=0, .hash=this->key_,
+                                 .count=this->settings_.count,
+                                 .tag=this->tagkey_, .urgency=this->urgency_};
+    AriaSharedMem::commit(&data, SHAREDMEM_SPACING);
+    this->settings_.count = data.count;
+    this->index_ = index;
+    this->x_ = data.x;
+    this->y_ = data.y;
+    if (this->window_ != None)
+    {
+        XMoveWindow(this->display_, this->window_, this->x_, this->y_);
+    }
+}
+
+/**
+ * @brief Draw the notification bubble.
+ * 
+ * @details The window is cleared to transparent first, so that the area
+ *          outside of the rounded corners is not drawn over.
+ */
+void x11bubble::redraw(void)
+{
+    double start = util::now();
+    cairo_t* cr = cairo_create(this->surface_);
+    cairo_set_operator(cr, CAIRO_OPERATOR_CLEAR);
+    cairo_paint(cr);
+    cairo_set_operator(cr, CAIRO_OPERATOR_OVER);
+    render::draw(cr, this->settings_, this->layout_);
+    cairo_destroy(cr);
+    cairo_surface_flush(this->surface_);
+    XFlush(this->display_);
+    util::profile("draw", start);
+}
+
+/**
+ * @brief Draw only the progress bar of the notification bubble.
+ * 
+ * @details Drawing is clipped to the area of the bar, which is inside the
+ *          margins, so only the background behind it has to be filled in
+ *          again.
+ */
+void x11bubble::redraw_bar(void)
+{
+    const struct render::layout& l = this->layout_;
+    cairo_t* cr = cairo_create(this->surface_);
+    cairo_rectangle(cr, l.barx, l.bary, l.barw, render::kBarHeight);
+    cairo_clip(cr);
+    cairo_set_operator(cr, CAIRO_OPERATOR_SOURCE);
+    gdk_cairo_set_source_rgba(cr, &this->settings_.background);
+    cairo_paint(cr);
+    cairo_set_operator(cr, CAIRO_OPERATOR_OVER);
+    render::draw_bar(cr, l.barx, l.bary, l.barw, render::kBarHeight,
+                     this->settings_.progress, this->settings_.foreground);
+    cairo_destroy(cr);
+    cairo_surface_flush(this->surface_);
+    XFlush(this->display_);
+}
+
+/**
+ * @brief Display the latest update of the progress bar.
+ * 
+ * @details New text replaces the body, which redraws the whole notification
+ *          bubble. Otherwise, only the bar is redrawn, if its fraction
+ *          changed.
+ */
+void x11bubble::show_progress(void)
+{
+    struct SharedMemPayload p = {};
+    bool changed = (this->settings_.progress != this->progress_.fraction);
+    this->settings_.progress = this->progress_.fraction;
+    if (this->progress_.newtext)
+    {
+        this->progress_.newtext = false;
+        strncpy(p.body, this->progress_.text.c_str(), sizeof(p.body)-1);
+        p.fields = SHAREDMEM_FIELD_BODY;
+        this->replace(p);
+    }
+    else if (changed)
+    {
+        this->redraw_bar();
+    }
+}
+
+/**
+ * @brief Handle an event from the X server.
+ * 
+ * @details Redraw when the window is exposed, and place the notification
+ *          bubble again when the work area changes.
+ * 
+ * @param[in] event The event.
+ */
+void x11bubble::handle_event(XEvent& event)
+{
+    if ((event.type == Expose) && (event.xexpose.count == 0))
+    {
+        this->redraw();
+    }
+    else if (geometry::is_workarea_event(this->display_, &event))
+    {
+        geometry::refresh(this->display_);
+        this->reposition();
+    }
+}
+
+/**
+ * @brief Handle a signal that was received.
+ * 
+ * @details SIGUSR1 means that another notification bubble in the same stack
+ *          was removed, see AriaSharedMem::notify(), so move to the new
+ *          position in shared memory. SIGUSR2 means that a duplicate, a
+ *          replacement, or a folded notification was sent, see
+ *          AriaSharedMem::coalesce(), AriaSharedMem::deliver(), and
+ *          AriaSharedMem::fold(), so show the new repeat count or contents,
+ *          and restart the timeout. Any other signal quits.
+ */
+void x11bubble::handle_signal(void)
+{
+    struct signalfd_siginfo info;
+    struct SharedMemType entry;
+    struct SharedMemPayload payload;
+    if (read(this->sigfd_, &info, sizeof(info)) != sizeof(info))
+    {
+        return;
+    }
+    if ((info.ssi_signo != SIGUSR1) && (info.ssi_signo != SIGUSR2))
+    {
+        this->done_ = true;
+        return;
+    }
+    if ((info.ssi_signo == SIGUSR2)
+        && ((AriaSharedMem::collect(this->tagkey_, &this->seen_, &payload) == 0)
+            || summary::collect(payload)))
+    {
+        this->replace(payload);
+        this->deadline_ = util::now() + (this->settings_.time * 1000.0);
+    }
+    if (AriaSharedMem::lookup(this->index_, getpid(), &entry) < 0)
+    {
+        return;
+    }
+    if (info.ssi_signo == SIGUSR2)
+    {
+        if (entry.count != this->settings_.count)
+        {
+            this->settings_.count = entry.count;
+            this->deadline_ = util::now() + (this->settings_.time * 1000.0);
+            this->redraw();
+        }
+    }
+    else
+    {
+        this->x_ = entry.x;
+        this->y_ = entry.y;
+        XMoveWindow(this->display_, this->window_, this->x_, this->y_);
+        XFlush(this->display_);
+    }
+}
+
+/**
+ * @brief Replace the title, body, or icon, with new contents that were handed
+ *        to the notification bubble by tag.
+ * 
+ * @details The notification bubble is laid out again, and if its size
+ *          changed, the window is resized and keeps its place in the stack,
+ *          which moves the rest of the stack. An icon that can not be loaded
+ *          is ignored, and the previous one is kept.
+ * 
+ * @param[in] p The new contents.
+ */
+void x11bubble::replace(const struct SharedMemPayload& p)
+{
+    std::string icon = this->settings_.icon;
+    int width = this->layout_.width;
+    int height = this->layout_.height;
+    cairo_surface_t* scratch;
+    cairo_t* cr;
+    if (p.fields & SHAREDMEM_FIELD_TITLE)
+    {
+        this->settings_.title = p.title;
+    }
+    if (p.fields & SHAREDMEM_FIELD_BODY)
+    {
+        this->settings_.body = p.body;
+    }
+    if (p.fields & SHAREDMEM_FIELD_ICON)
+    {
+        this->settings_.icon = p.icon;
+    }
+
+    scratch = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, 1, 1);
+    cr = cairo_create(scratch);
+    render::release(this->layout_);
+    if (render::lay_out(cr, this->settings_, this->layout_) < 0)
+    {
+        render::release(this->layout_);
+        this->settings_.icon = icon;
+        render::lay_out(cr, this->settings_, this->layout_);
+    }
+    cairo_destroy(cr);
+    cairo_surface_destroy(scratch);
+
+    if ((this->layout_.width != width) || (this->layout_.height != height))
+    {
+        XResizeWindow(this->display_, this->window_, this->layout_.width,
+                      this->layout_.height);
+        cairo_xlib_surface_set_size(this->surface_, this->layout_.width,
+                                    this->layout_.height);
+        this->reposition();
+    }
+    this->redraw();
+}
+
+ARIA_NAMESPACE_END